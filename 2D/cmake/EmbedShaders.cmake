@@ -0,0 +1,21 @@
+# Writes every .glsl file in SHADER_DIR into the header OUTPUT as constexpr
+# string_views. The build runs it with cmake -P whenever a shader changes.
+file(GLOB shaders "${SHADER_DIR}/*.glsl")
+list(SORT shaders)
+
+set(content "// Generated from res/shaders by cmake/EmbedShaders.cmake, edit the shaders instead\n")
+string(APPEND content "#pragma once\n\n#include <string_view>\n\n")
+string(APPEND content "struct EmbeddedShader\n{\n    std::string_view name;\n    std::string_view source;\n};\n\n")
+string(APPEND content "constexpr EmbeddedShader EmbeddedShaders[] = {\n")
+foreach(shader ${shaders})
+    get_filename_component(name "${shader}" NAME)
+    file(READ "${shader}" source)
+    string(FIND "${source}" ")glsl\"" clash)
+    if(NOT clash EQUAL -1)
+        message(FATAL_ERROR "${name} contains )glsl\" and can't go in a raw string literal")
+    endif()
+    string(APPEND content "    { \"${name}\", R\"glsl(${source})glsl\" },\n")
+endforeach()
+string(APPEND content "};\n")
+
+file(WRITE "${OUTPUT}" "${content}")
@@ -0,0 +1,27 @@
+#version 330 core
+
+out vec4 FragColor;
+
+// Live fraction of each 2^k x 2^k block of cells, one block per texel
+uniform sampler2D u_Density;
+// Block under the window's top left corner, fractional when panned
+uniform vec2 u_Origin;
+// Pixels per block, 1 or more
+uniform float u_BlockSize;
+uniform float u_ViewportHeight;
+
+const vec4 LiveColor = vec4(0.95, 0.95, 0.9, 1.0);
+const vec4 DeadColor = vec4(0.08, 0.09, 0.11, 1.0);
+
+void main()
+{
+   // Window y goes up, cell y goes down
+   vec2 pixel = vec2(gl_FragCoord.x, u_ViewportHeight - gl_FragCoord.y);
+   ivec2 block = ivec2(floor(u_Origin + pixel / u_BlockSize));
+
+   float density = 0.0;
+   if (all(greaterThanEqual(block, ivec2(0))) && all(lessThan(block, textureSize(u_Density, 0))))
+      density = texelFetch(u_Density, block, 0).r;
+   // A lone cell still shows, denser blocks are brighter
+   FragColor = density > 0.0 ? mix(DeadColor, LiveColor, 0.35 + 0.65 * sqrt(density)) : DeadColor;
+}
\ No newline at end of file
@@ -2,9 +2,40 @@
 
 out vec4 FragColor;
 
-uniform vec4 u_Color;
+// Physical page cache, pages of u_PageSize texels side by side, u_PagesAcross
+// to a row. 32 cells per texel, cell x is bit x % 32 of its texel.
+uniform usampler2D u_Pages;
+// One entry per page of the view, its page in u_Pages plus one, 0 if empty
+uniform usampler2D u_PageTable;
+uniform ivec2 u_PageSize;
+uniform int u_PagesAcross;
+// Cell under the window's top left corner, counted from the first page's
+// corner and fractional when panned
+uniform vec2 u_Origin;
+uniform float u_CellSize;
+uniform float u_ViewportHeight;
+
+const vec4 LiveColor = vec4(0.95, 0.95, 0.9, 1.0);
+const vec4 DeadColor = vec4(0.08, 0.09, 0.11, 1.0);
 
 void main()
 {
-   FragColor = u_Color;
-}
\ No newline at end of file
+   // Window y goes up, cell y goes down
+   vec2 pixel = vec2(gl_FragCoord.x, u_ViewportHeight - gl_FragCoord.y);
+   ivec2 cell = ivec2(floor(u_Origin + pixel / u_CellSize));
+
+   ivec2 texel = ivec2(cell.x >> 5, cell.y);
+   ivec2 page = texel / u_PageSize;
+   bool alive = false;
+   if (all(greaterThanEqual(texel, ivec2(0))) && all(lessThan(page, textureSize(u_PageTable, 0))))
+   {
+      uint entry = texelFetch(u_PageTable, page, 0).r;
+      if (entry != 0u)
+      {
+         int slot = int(entry) - 1;
+         ivec2 physical = ivec2(slot % u_PagesAcross, slot / u_PagesAcross) * u_PageSize + texel - page * u_PageSize;
+         alive = ((texelFetch(u_Pages, physical, 0).r >> uint(cell.x & 31)) & 1u) != 0u;
+      }
+   }
+   FragColor = alive ? LiveColor : DeadColor;
+}
@@ -0,0 +1,11 @@
+#version 330 core
+
+out vec4 FragColor;
+
+// Same as LiveColor in fragment.glsl, the clear colour is the dead one
+const vec4 LiveColor = vec4(0.95, 0.95, 0.9, 1.0);
+
+void main()
+{
+   FragColor = LiveColor;
+}
\ No newline at end of file
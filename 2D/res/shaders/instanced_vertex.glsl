@@ -0,0 +1,19 @@
+#version 330 core
+
+// Unit quad corner, (0, 0) to (1, 1)
+layout(location = 0) in vec2 a_Corner;
+// Live cell, relative to the top left cell of the camera tile
+layout(location = 1) in ivec2 a_Cell;
+
+// Cell under the window's top left corner, relative to the same, fractional when panned
+uniform vec2 u_Origin;
+uniform float u_CellSize;
+uniform vec2 u_ViewportSize;
+
+void main()
+{
+   vec2 pixel = (vec2(a_Cell) + a_Corner - u_Origin) * u_CellSize;
+   // Window y goes up, cell y goes down
+   vec2 position = pixel / u_ViewportSize * 2.0 - 1.0;
+   gl_Position = vec4(position.x, -position.y, 0.0, 1.0);
+}
\ No newline at end of file
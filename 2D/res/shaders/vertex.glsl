@@ -1,12 +1,9 @@
 #version 330 core
 
-layout(location = 0) in vec4 position;
-layout(location = 1) in vec3 color;
-
-out vec3 vertexColor;
-
+// One triangle that covers the whole window, made from the vertex index so
+// no vertex buffer is needed: (-1, -1), (3, -1), (-1, 3)
 void main()
 {
-   gl_Position = position;
-   vertexColor = color;
+   vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+   gl_Position = vec4(position * 2.0 - 1.0, 0.0, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,393 @@
+#include "Apgcode.h"
+#include "Hashlife.h"
+#include "PatternReader.h"
+
+#include <algorithm>
+#include <cstring>
+
+static const char Digits[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+// 13 strips of 64 columns with separators, the most a 64x64 board can need
+static const std::size_t MaxCodeLength = 13 * 65;
+
+static int DigitValue(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'z')
+        return c - 'a' + 10;
+    return -1;
+}
+
+static uint64_t ReverseBits(uint64_t bits)
+{
+    bits = ((bits >> 1) & 0x5555555555555555ull) | ((bits & 0x5555555555555555ull) << 1);
+    bits = ((bits >> 2) & 0x3333333333333333ull) | ((bits & 0x3333333333333333ull) << 2);
+    bits = ((bits >> 4) & 0x0F0F0F0F0F0F0F0Full) | ((bits & 0x0F0F0F0F0F0F0F0Full) << 4);
+    return __builtin_bswap64(bits);
+}
+
+// Cell (x, y) goes to (y, x) inside the top left `size` square (a power of
+// two, the cells must all be in it): swap the off-diagonal halves, then the
+// quarters within them and so on down to single cells
+static void Transpose(uint64_t rows[64], unsigned int size)
+{
+    static const uint64_t Masks[] = { 0x5555555555555555ull, 0x3333333333333333ull, 0x0F0F0F0F0F0F0F0Full,
+                                      0x00FF00FF00FF00FFull, 0x0000FFFF0000FFFFull, 0x00000000FFFFFFFFull };
+    for (unsigned int j = size / 2, level = (unsigned int)__builtin_ctz(size); j; j >>= 1)
+    {
+        uint64_t mask = Masks[--level];
+        for (unsigned int k = 0; k < size; k = ((k | j) + 1) & ~j)
+        {
+            uint64_t t = ((rows[k] >> j) ^ rows[k | j]) & mask;
+            rows[k] ^= t << j;
+            rows[k | j] ^= t;
+        }
+    }
+}
+
+void NormaliseBoard(ObjectBoard& board)
+{
+    unsigned int top = 0, bottom = 64;
+    while (top < 64 && !board.rows[top])
+        top++;
+    if (top == 64)
+    {
+        board.width = board.height = 0;
+        return;
+    }
+    // Small objects are the norm, skip empty rows four at a time
+    while (!(board.rows[bottom - 1] | board.rows[bottom - 2] | board.rows[bottom - 3] | board.rows[bottom - 4]))
+        bottom -= 4;
+    while (!board.rows[bottom - 1])
+        bottom--;
+
+    uint64_t columns = 0;
+    for (unsigned int y = top; y < bottom; y++)
+        columns |= board.rows[y];
+    unsigned int left = (unsigned int)__builtin_ctzll(columns);
+    if (top || left)
+    {
+        for (unsigned int y = top; y < bottom; y++)
+            board.rows[y - top] = board.rows[y] >> left;
+        std::memset(board.rows + (bottom - top), 0, top * sizeof(uint64_t));
+    }
+    board.width = 64 - (unsigned int)__builtin_clzll(columns) - left;
+    board.height = bottom - top;
+}
+
+bool CaptureObject(const Hashlife& life, ObjectBoard& board)
+{
+    PatternReader reader(life);
+    int64_t left = 0, top = 0, right = 0, bottom = 0;
+    if (!reader.GetBounds(left, top, right, bottom) || right - left > 64 || bottom - top > 64)
+        return false;
+
+    // Leaf rows are bytes at any offset from the box, cells outside it are dead
+    std::memset(board.rows, 0, sizeof(board.rows));
+    reader.ForEachBand([&](int64_t band, const std::vector<PatternLeaf>& leaves)
+    {
+        for (const PatternLeaf& leaf : leaves)
+        {
+            int64_t shift = leaf.column * 8 - left;
+            for (int64_t r = 0; r < 8; r++)
+            {
+                int64_t y = band * 8 + r - top;
+                uint64_t cells = (leaf.bits >> (r * 8)) & 0xFF;
+                if (y < 0 || y >= 64 || !cells)
+                    continue;
+                board.rows[y] |= shift >= 0 ? cells << shift : cells >> -shift;
+            }
+        }
+        return true;
+    });
+    NormaliseBoard(board);
+    return true;
+}
+
+// Bit i of a byte to bit 0 of byte i
+static inline uint64_t Spread(uint64_t byte)
+{
+    byte = (byte | (byte << 28)) & 0x0000000F0000000Full;
+    byte = (byte | (byte << 14)) & 0x0003000300030003ull;
+    return (byte | (byte << 7)) & 0x0101010101010101ull;
+}
+
+// Characters PutBlanks writes for a run of blank columns
+static inline std::size_t BlanksLength(unsigned int blanks)
+{
+    if (blanks < 4)
+        return 1;
+    return blanks < 40 ? 2 : blanks < 43 ? 3 : 4;
+}
+
+// Code length of one strip from the mask of its live columns, without
+// encoding it: one character per live column plus the blank runs before them
+static inline std::size_t StripLength(uint64_t columns)
+{
+    if (!columns)
+        return 0;
+    std::size_t length = (std::size_t)__builtin_popcountll(columns);
+    uint64_t blanks = ~columns & (((uint64_t)1 << (63 - __builtin_clzll(columns))) - 1);
+    if (__builtin_popcountll(blanks) < 40)
+    {
+        // A run takes one character, two if it has four blanks or more
+        uint64_t four = blanks & (blanks >> 1) & (blanks >> 2) & (blanks >> 3);
+        return length + (std::size_t)__builtin_popcountll(blanks & ~(blanks << 1))
+                      + (std::size_t)__builtin_popcountll(four & ~(four << 1));
+    }
+    while (blanks)
+    {
+        unsigned int start = (unsigned int)__builtin_ctzll(blanks);
+        unsigned int run = (unsigned int)__builtin_ctzll(~(blanks >> start));
+        length += BlanksLength(run);
+        blanks &= blanks + ((uint64_t)1 << start);
+    }
+    return length;
+}
+
+static inline char* PutBlanks(char* p, unsigned int blanks)
+{
+    for (; blanks >= 4; blanks -= std::min(blanks, 39u))
+    {
+        *p++ = 'y';
+        *p++ = Digits[std::min(blanks, 39u) - 4];
+    }
+    if (blanks == 1)
+        *p++ = '0';
+    else if (blanks == 2)
+        *p++ = 'w';
+    else if (blanks == 3)
+        *p++ = 'x';
+    return p;
+}
+
+// Code of a normalised board into `out`, returns the length. With a `bound`
+// of the same length it gives up and returns 0 as soon as the code is
+// certain to sort after it.
+static std::size_t Encode(const ObjectBoard& board, char* out, const char* bound = nullptr)
+{
+    char* p = out;
+    const char* checked = out;
+    if (!board.height)
+    {
+        *p++ = '0';
+        return 1;
+    }
+    for (unsigned int strip = 0; strip * 5 < board.height; strip++)
+    {
+        if (strip)
+            *p++ = 'z';
+        const uint64_t* r = board.rows + strip * 5;
+        uint64_t r4 = strip * 5 + 4 < 64 ? r[4] : 0;
+        uint64_t any = r[0] | r[1] | r[2] | r[3] | r4;
+        unsigned int blanks = 0;
+
+        // Eight columns at a time, each byte of `values` is one column's character.
+        // Blank columns after the strip's last live one are left out.
+        for (unsigned int x = 0; any >> x; x += 8)
+        {
+            uint64_t values = Spread((r[0] >> x) & 0xFF) | Spread((r[1] >> x) & 0xFF) << 1
+                            | Spread((r[2] >> x) & 0xFF) << 2 | Spread((r[3] >> x) & 0xFF) << 3
+                            | Spread((r4 >> x) & 0xFF) << 4;
+            unsigned int count = (any >> x) >> 8 ? 8 : 8 - (unsigned int)__builtin_clzll(values) / 8;
+            for (unsigned int c = 0; c < count; c++, values >>= 8)
+            {
+                unsigned int value = (unsigned int)values & 0x1F;
+                if (!value)
+                {
+                    blanks++;
+                    continue;
+                }
+                if (blanks)
+                {
+                    p = PutBlanks(p, blanks);
+                    blanks = 0;
+                }
+                *p++ = Digits[value];
+                for (; bound && checked < p; checked++)
+                {
+                    if (*checked != bound[checked - out])
+                    {
+                        if (*checked > bound[checked - out])
+                            return 0;
+                        bound = nullptr;
+                    }
+                }
+            }
+            if (x == 56)
+                break;
+        }
+    }
+    return (std::size_t)(p - out);
+}
+
+std::string EncodeWechsler(const ObjectBoard& board)
+{
+    char code[MaxCodeLength];
+    return std::string(code, Encode(board, code));
+}
+
+static bool CodeLess(const char* a, std::size_t aLength, const char* b, std::size_t bLength)
+{
+    if (aLength != bLength)
+        return aLength < bLength;
+    return std::memcmp(a, b, aLength) < 0;
+}
+
+bool WechslerLess(const std::string& a, const std::string& b)
+{
+    return CodeLess(a.data(), a.size(), b.data(), b.size());
+}
+
+// Live column masks of a board's strips, top down (`down`) or bottom up
+static unsigned int StripMasks(const ObjectBoard& board, uint64_t down[13], uint64_t up[13])
+{
+    unsigned int strips = (board.height + 4) / 5;
+    for (unsigned int strip = 0; strip < strips; strip++)
+    {
+        down[strip] = up[strip] = 0;
+        for (unsigned int k = strip * 5; k < strip * 5 + 5 && k < board.height; k++)
+        {
+            down[strip] |= board.rows[k];
+            up[strip] |= board.rows[board.height - 1 - k];
+        }
+    }
+    return strips;
+}
+
+std::string CanonicalWechsler(const ObjectBoard& board)
+{
+    ObjectBoard boards[2];
+    boards[0] = board;
+    NormaliseBoard(boards[0]);
+    if (!boards[0].height)
+        return "0";
+
+    // The other four orientations are flips of the transpose
+    ObjectBoard& transposed = boards[1];
+    unsigned int size = 1;
+    while (size < boards[0].width || size < boards[0].height)
+        size *= 2;
+    std::memcpy(transposed.rows, boards[0].rows, size * sizeof(uint64_t));
+    Transpose(transposed.rows, size);
+    transposed.width = boards[0].height;
+    transposed.height = boards[0].width;
+
+    // Code lengths of all 8 come from the strips' column masks, bit reversed
+    // for a horizontal flip. Only the shortest get encoded, usually one or two.
+    std::size_t lengths[8];
+    std::size_t shortest = ~(std::size_t)0;
+    for (unsigned int t = 0; t < 2; t++)
+    {
+        uint64_t masks[2][13];
+        unsigned int strips = StripMasks(boards[t], masks[0], masks[1]);
+        for (unsigned int orientation = t * 4; orientation < t * 4 + 4; orientation++)
+        {
+            const uint64_t* m = masks[(orientation >> 1) & 1];
+            std::size_t length = strips - 1;
+            for (unsigned int strip = 0; strip < strips; strip++)
+                length += StripLength(orientation & 1 ? ReverseBits(m[strip]) >> (64 - boards[t].width) : m[strip]);
+            lengths[orientation] = length;
+            shortest = std::min(shortest, length);
+        }
+    }
+
+    char best[MaxCodeLength], code[MaxCodeLength];
+    std::size_t bestLength = 0;
+    ObjectBoard b, bestBoard;
+    for (unsigned int orientation = 0; orientation < 8; orientation++)
+    {
+        if (lengths[orientation] != shortest)
+            continue;
+        const ObjectBoard& base = boards[orientation >> 2];
+        b.width = base.width;
+        b.height = base.height;
+        for (unsigned int y = 0; y < b.height; y++)
+        {
+            uint64_t row = base.rows[orientation & 2 ? b.height - 1 - y : y];
+            b.rows[y] = orientation & 1 ? ReverseBits(row) >> (64 - b.width) : row;
+        }
+        // Symmetric objects come out the same several times, only one needs encoding
+        if (bestLength && b.width == bestBoard.width && b.height == bestBoard.height
+            && std::memcmp(b.rows, bestBoard.rows, b.height * sizeof(uint64_t)) == 0)
+            continue;
+        // Encode only reads the strips the height covers, the rest can stay stale
+        if (b.height < 64)
+            std::memset(b.rows + b.height, 0, std::min(64u - b.height, 5u) * sizeof(uint64_t));
+
+        std::size_t length = Encode(b, code, bestLength ? best : nullptr);
+        if (length && (!bestLength || CodeLess(code, length, best, bestLength)))
+        {
+            std::memcpy(best, code, length);
+            bestLength = length;
+            bestBoard.width = b.width;
+            bestBoard.height = b.height;
+            std::memcpy(bestBoard.rows, b.rows, b.height * sizeof(uint64_t));
+        }
+    }
+    return std::string(best, bestLength);
+}
+
+std::string MakeApgcode(const std::string& prefix, const ObjectBoard& board)
+{
+    return prefix + "_" + CanonicalWechsler(board);
+}
+
+bool DecodeApgcode(const std::string& apgcode, ObjectBoard& board)
+{
+    std::size_t start = apgcode.find('_');
+    start = start == std::string::npos ? 0 : start + 1;
+    std::memset(board.rows, 0, sizeof(board.rows));
+
+    unsigned int x = 0, y = 0;
+    for (std::size_t i = start; i < apgcode.size(); i++)
+    {
+        char c = apgcode[i];
+        unsigned int blanks = 0;
+        if (c == 'z')
+        {
+            x = 0;
+            y += 5;
+            continue;
+        }
+        if (c == 'w')
+            blanks = 2;
+        else if (c == 'x')
+            blanks = 3;
+        else if (c == 'y')
+        {
+            int value = i + 1 < apgcode.size() ? DigitValue(apgcode[++i]) : -1;
+            if (value < 0)
+                return false;
+            blanks = 4 + (unsigned int)value;
+        }
+        else
+        {
+            int value = DigitValue(c);
+            if (value < 0 || value >= 32)
+                return false;
+            if (x >= 64 || (value && y + (31 - __builtin_clz((unsigned int)value)) >= 64))
+                return false;
+            for (unsigned int k = 0; k < 5; k++)
+                if (value & (1 << k))
+                    board.rows[y + k] |= (uint64_t)1 << x;
+            blanks = 1;
+        }
+        x += blanks;
+    }
+    NormaliseBoard(board);
+    return true;
+}
+
+uint64_t ApgcodeHash(const char* apgcode, std::size_t length)
+{
+    // FNV-1a over the bytes, then a final mix so short codes spread over all 64 bits
+    uint64_t h = 0xCBF29CE484222325ull;
+    for (std::size_t i = 0; i < length; i++)
+        h = (h ^ (unsigned char)apgcode[i]) * 0x100000001B3ull;
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDull;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ull;
+    return h ^ (h >> 33);
+}
@@ -0,0 +1,98 @@
+#include "Camera.h"
+
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <cmath>
+
+static const double WheelOctaves = 0.25;      // zoom per wheel notch
+static const double KeyOctavesPerSecond = 2.0;
+static const double PanWindowsPerSecond = 0.5;
+
+Camera::Camera(double centreX, double centreY, double zoomLog2)
+    : m_CentreX(centreX), m_CentreY(centreY), m_ZoomLog2(std::max(MinZoomLog2, std::min(zoomLog2, MaxZoomLog2))),
+      m_Scroll(0.0), m_Dragging(false), m_DragX(0.0), m_DragY(0.0)
+{
+}
+
+void Camera::Attach(GLFWwindow* window)
+{
+    glfwSetWindowUserPointer(window, this);
+    glfwSetScrollCallback(window, OnScroll);
+}
+
+void Camera::OnScroll(GLFWwindow* window, double, double y)
+{
+    Camera* camera = (Camera*)glfwGetWindowUserPointer(window);
+    if (camera)
+        camera->m_Scroll += y;
+}
+
+double Camera::GetCellSize() const
+{
+    return std::exp2(m_ZoomLog2);
+}
+
+void Camera::Update(GLFWwindow* window, double seconds)
+{
+    int windowWidth = 0, windowHeight = 0, width = 0, height = 0;
+    glfwGetWindowSize(window, &windowWidth, &windowHeight);
+    glfwGetFramebufferSize(window, &width, &height);
+    if (windowWidth <= 0 || windowHeight <= 0 || width <= 0 || height <= 0)
+        return;
+
+    // The cursor is in window coordinates, which are smaller on high DPI screens
+    double cursorX = 0.0, cursorY = 0.0;
+    glfwGetCursorPos(window, &cursorX, &cursorY);
+    cursorX *= (double)width / windowWidth;
+    cursorY *= (double)height / windowHeight;
+
+    double cellSize = GetCellSize();
+    if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS)
+    {
+        if (m_Dragging)
+        {
+            m_CentreX -= (cursorX - m_DragX) / cellSize;
+            m_CentreY -= (cursorY - m_DragY) / cellSize;
+        }
+        m_Dragging = true;
+        m_DragX = cursorX;
+        m_DragY = cursorY;
+    }
+    else
+        m_Dragging = false;
+
+    double pan = seconds * PanWindowsPerSecond / cellSize;
+    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+        m_CentreY -= pan * height;
+    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+        m_CentreY += pan * height;
+    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+        m_CentreX -= pan * width;
+    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+        m_CentreX += pan * width;
+
+    double zoom = 0.0;
+    if (glfwGetKey(window, GLFW_KEY_EQUAL) == GLFW_PRESS || glfwGetKey(window, GLFW_KEY_KP_ADD) == GLFW_PRESS)
+        zoom += seconds * KeyOctavesPerSecond;
+    if (glfwGetKey(window, GLFW_KEY_MINUS) == GLFW_PRESS || glfwGetKey(window, GLFW_KEY_KP_SUBTRACT) == GLFW_PRESS)
+        zoom -= seconds * KeyOctavesPerSecond;
+    if (zoom != 0.0)
+        ZoomAbout(zoom, width / 2.0, height / 2.0, width, height);
+    if (m_Scroll != 0.0)
+    {
+        ZoomAbout(m_Scroll * WheelOctaves, cursorX, cursorY, width, height);
+        m_Scroll = 0.0;
+    }
+}
+
+void Camera::ZoomAbout(double octaves, double x, double y, int viewportWidth, int viewportHeight)
+{
+    double offsetX = x - viewportWidth / 2.0;
+    double offsetY = y - viewportHeight / 2.0;
+    double cellX = m_CentreX + offsetX / GetCellSize();
+    double cellY = m_CentreY + offsetY / GetCellSize();
+    m_ZoomLog2 = std::max(MinZoomLog2, std::min(m_ZoomLog2 + octaves, MaxZoomLog2));
+    m_CentreX = cellX - offsetX / GetCellSize();
+    m_CentreY = cellY - offsetY / GetCellSize();
+}
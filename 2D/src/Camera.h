@@ -0,0 +1,45 @@
+#pragma once
+
+struct GLFWwindow;
+
+/**
+ * Pan and zoom for the cell view.
+ *
+ * Dragging with the left button moves the board along with the cursor and
+ * WASD pans half a window a second. The scroll wheel zooms about the cell
+ * under the cursor, + and - about the middle of the window. Zoom is a power
+ * of two exponent, from 64 pixels per cell down to 2^60 cells per pixel, so
+ * each wheel notch is the same step at any scale.
+ */
+class Camera
+{
+public:
+    static constexpr double MinZoomLog2 = -60.0;
+    static constexpr double MaxZoomLog2 = 6.0;
+
+    Camera(double centreX = 0.0, double centreY = 0.0, double zoomLog2 = 2.0);
+
+    // Takes the window's scroll input, the camera has to outlive the window
+    void Attach(GLFWwindow* window);
+    // Once a frame, `seconds` since the last one
+    void Update(GLFWwindow* window, double seconds);
+
+    double GetCentreX() const { return m_CentreX; }
+    double GetCentreY() const { return m_CentreY; }
+    // Pixels per cell, below 1 when zoomed out
+    double GetCellSize() const;
+
+    // Keeps the cell under framebuffer pixel (x, y) where it is
+    void ZoomAbout(double octaves, double x, double y, int viewportWidth, int viewportHeight);
+
+private:
+    double m_CentreX;
+    double m_CentreY;
+    double m_ZoomLog2;
+    double m_Scroll;         // wheel notches since the last update
+    bool m_Dragging;
+    double m_DragX;          // cursor at the last update, in framebuffer pixels
+    double m_DragY;
+
+    static void OnScroll(GLFWwindow* window, double x, double y);
+};
@@ -0,0 +1,425 @@
+#include "CellRenderer.h"
+#include "Hashlife.h"
+#include "IndexBuffer.h"
+#include "PatternReader.h"
+#include "Renderer.h"
+#include "Shader.h"
+#include "VertexBuffer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+// Same as DeadColor in fragment.glsl, instanced frames clear to it
+static const float DeadColor[4] = { 0.08f, 0.09f, 0.11f, 1.0f };
+
+static const float QuadCorners[] = { 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f, 0.0f, 1.0f };
+static const unsigned int QuadIndices[] = { 0, 1, 2, 2, 3, 0 };
+
+// Views zoomed out further than this many cells per pixel aren't worth telling apart
+static const double MinCellSize = std::ldexp(1.0, -60);
+
+static void CreateTexture(unsigned int& texture)
+{
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    // Integer textures can't be filtered, texelFetch ignores these anyway
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+}
+
+CellRenderer::CellRenderer(Shader& program, Shader& instancedProgram, Shader& densityProgram,
+                           unsigned int uploadBuffers)
+    : m_Program(program), m_VertexArray(0), m_PageTexture{ 0, 0, 0, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, 4 },
+      m_PageTable{ 0, 0, 0, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, 4 }, m_MaxTextureSize(0),
+      m_InstancedProgram(instancedProgram),
+      m_QuadArray(0), m_Instanced(false), m_DensityProgram(densityProgram),
+      m_DensityTexture{ 0, 0, 0, GL_R8, GL_RED, GL_UNSIGNED_BYTE, 1 },
+      m_CentreX(0.0), m_CentreY(0.0), m_CellSize(1.0)
+{
+    // Core profile draws need a vertex array even with no attributes
+    glGenVertexArrays(1, &m_VertexArray);
+
+    CreateTexture(m_PageTexture.id);
+    CreateTexture(m_PageTable.id);
+    CreateTexture(m_DensityTexture.id);
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &m_MaxTextureSize);
+
+    if (uploadBuffers)
+        m_Upload.reset(new StreamBuffer(GL_PIXEL_UNPACK_BUFFER, std::min(uploadBuffers, MaxUploadBuffers)));
+    for (FrameTimers& timers : m_Timers)
+    {
+        glGenQueries(1, &timers.upload);
+        glGenQueries(1, &timers.draw);
+    }
+
+    // The quad's corners and indices live in the vertex array, instances are pointed at every frame
+    glGenVertexArrays(1, &m_QuadArray);
+    glBindVertexArray(m_QuadArray);
+    m_QuadVertices.reset(new VertexBuffer(QuadCorners, sizeof(QuadCorners)));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), nullptr);
+    m_QuadIndices.reset(new IndexBuffer(QuadIndices, 6));
+    glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(1, 1);
+    glBindVertexArray(0);
+    m_Instances.reset(new StreamBuffer(GL_ARRAY_BUFFER));
+}
+
+CellRenderer::~CellRenderer()
+{
+    for (FrameTimers& timers : m_Timers)
+    {
+        glDeleteQueries(1, &timers.upload);
+        glDeleteQueries(1, &timers.draw);
+    }
+    m_Upload.reset();
+    m_Instances.reset();
+    m_QuadIndices.reset();
+    m_QuadVertices.reset();
+    glDeleteVertexArrays(1, &m_QuadArray);
+    glDeleteTextures(1, &m_DensityTexture.id);
+    glDeleteTextures(1, &m_PageTable.id);
+    glDeleteTextures(1, &m_PageTexture.id);
+    glDeleteVertexArrays(1, &m_VertexArray);
+}
+
+const char* CellRenderer::GetUploadMode() const
+{
+    if (!m_Upload)
+        return "synchronous";
+    return m_Upload->IsPersistent() ? "persistent" : "orphaned";
+}
+
+void CellRenderer::SetView(double centreX, double centreY, double cellSize)
+{
+    m_CentreX = centreX;
+    m_CentreY = centreY;
+    m_CellSize = std::max(cellSize, MinCellSize);
+}
+
+void CellRenderer::Draw(const Hashlife& life, int viewportWidth, int viewportHeight)
+{
+    if (viewportWidth <= 0 || viewportHeight <= 0)
+        return;
+    FrameTimers& timers = m_Timers[m_Stats.frames % TimerLatency];
+    ReadTimers(timers);
+    if (m_CellSize < 1.0)
+    {
+        DrawDensity(life, timers, viewportWidth, viewportHeight);
+        return;
+    }
+
+    // Cells under the window, a partly visible one at each edge included, out to whole pages
+    double viewLeft = m_CentreX - viewportWidth / (2.0 * m_CellSize);
+    double viewTop = m_CentreY - viewportHeight / (2.0 * m_CellSize);
+    int64_t left = (int64_t)std::floor(viewLeft) & ~(int64_t)(PageCache::PageCells - 1);
+    int64_t top = (int64_t)std::floor(viewTop) & ~(int64_t)(PageCache::PageRows - 1);
+    int64_t right = (int64_t)std::floor(viewLeft + viewportWidth / m_CellSize) + 1;
+    int64_t bottom = (int64_t)std::floor(viewTop + viewportHeight / m_CellSize) + 1;
+    int pagesWide = (int)((right - left + PageCache::PageCells - 1) / PageCache::PageCells);
+    int pagesHigh = (int)((bottom - top + PageCache::PageRows - 1) / PageCache::PageRows);
+    int width = pagesWide * PageCache::PageWords;
+    int height = pagesHigh * PageCache::PageRows;
+
+    auto start = std::chrono::steady_clock::now();
+    std::size_t stride = (std::size_t)width * sizeof(uint32_t);
+    m_Words.assign((std::size_t)width * height, 0);
+    PatternReader reader(life);
+    reader.ReadRegion(left, top, (uint64_t)width * 32, (uint64_t)height, (uint8_t*)m_Words.data(), stride);
+
+    // Quads while they'd be a smaller upload than the raster by a margin, the margin keeps it from flickering
+    uint64_t live = CountLive();
+    uint64_t cells = (uint64_t)width * 32 * (uint64_t)height;
+    bool fits = (int64_t)width * 32 <= MaxInstancedSpan && height <= MaxInstancedSpan;
+    m_Instanced = fits && live * (m_Instanced ? TextureDensity : InstancedDensity) < cells;
+    if (m_Instanced)
+    {
+        m_Stats.fillMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        DrawInstanced(timers, live, width, height, (float)(viewLeft - (double)left), (float)(viewTop - (double)top),
+                      viewportWidth, viewportHeight);
+        return;
+    }
+
+    // Only pages that are new to the cache or changed go up
+    unsigned int pages = (unsigned int)pagesWide * (unsigned int)pagesHigh;
+    if (pages > m_Pages.GetCapacity())
+        ReservePages(pages);
+    m_Table.resize(pages);
+    // Past the largest page texture the pages that don't fit show as empty
+    uint64_t evictions = m_Pages.GetEvictions();
+    m_Pages.Update(m_Words.data(), (std::size_t)width, left / PageCache::PageCells, top / PageCache::PageRows,
+                   pagesWide, pagesHigh, m_Table.data());
+    m_Stats.evictions += m_Pages.GetEvictions() - evictions;
+    m_Rects.clear();
+    for (const PageCache::Upload& page : m_Pages.GetUploads())
+        m_Rects.push_back({ page.x * PageCache::PageWords, page.y * PageCache::PageRows, PageCache::PageWords,
+                            PageCache::PageRows, (int)(page.slot % PagesAcross) * PageCache::PageWords,
+                            (int)(page.slot / PagesAcross) * PageCache::PageRows });
+    m_Stats.fillMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    glBeginQuery(GL_TIME_ELAPSED, timers.upload);
+    bool uploaded = m_Rects.empty() || Upload(m_PageTexture, (const uint8_t*)m_Words.data(), width, height);
+    if (uploaded)
+    {
+        // A few bytes per page, straight from memory
+        if (m_PageTable.width != pagesWide || m_PageTable.height != pagesHigh)
+            Allocate(m_PageTable, pagesWide, pagesHigh);
+        glBindTexture(GL_TEXTURE_2D, m_PageTable.id);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, pagesWide, pagesHigh, m_PageTable.format, m_PageTable.type,
+                        m_Table.data());
+        m_Stats.uploadBytes += (uint64_t)pages * sizeof(uint32_t);
+    }
+    glEndQuery(GL_TIME_ELAPSED);
+    // A lost upload leaves the slots behind the cache's copies, start over and send every page next frame
+    if (!uploaded)
+    {
+        m_Pages.Reset(m_Pages.GetCapacity());
+        return;
+    }
+
+    m_Program.Bind();
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, m_PageTexture.id);
+    m_Program.SetUniform1i("u_Pages", 0);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, m_PageTable.id);
+    m_Program.SetUniform1i("u_PageTable", 1);
+    glActiveTexture(GL_TEXTURE0);
+    m_Program.SetUniform2i("u_PageSize", PageCache::PageWords, PageCache::PageRows);
+    m_Program.SetUniform1i("u_PagesAcross", (int)PagesAcross);
+    // Only the offset from the first page goes to the GPU, floats can't hold far away coordinates
+    m_Program.SetUniform2f("u_Origin", (float)(viewLeft - (double)left), (float)(viewTop - (double)top));
+    m_Program.SetUniform1f("u_CellSize", (float)m_CellSize);
+    m_Program.SetUniform1f("u_ViewportHeight", (float)viewportHeight);
+
+    glBindVertexArray(m_VertexArray);
+    glBeginQuery(GL_TIME_ELAPSED, timers.draw);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glEndQuery(GL_TIME_ELAPSED);
+    timers.pending = true;
+    m_Stats.frames++;
+}
+
+// Sizes the texture, dropping what it held
+void CellRenderer::Allocate(Texture& texture, int width, int height)
+{
+    glBindTexture(GL_TEXTURE_2D, texture.id);
+    glTexImage2D(GL_TEXTURE_2D, 0, texture.internalFormat, width, height, 0, texture.format, texture.type, nullptr);
+    texture.width = width;
+    texture.height = height;
+}
+
+// Sends m_Rects of the width x height image at `source` to the texture,
+// through the next upload buffer segment if there is one
+bool CellRenderer::Upload(Texture& texture, const uint8_t* source, int width, int height)
+{
+    std::size_t stride = (std::size_t)width * texture.texelBytes;
+    std::uintptr_t pixels = (std::uintptr_t)source;
+    if (m_Upload)
+    {
+        // The segment is laid out like the whole image, but only the rectangles are written and copied
+        uint8_t* mapped = (uint8_t*)m_Upload->Map(stride * height);
+        if (mapped)
+        {
+            for (const UploadRect& rect : m_Rects)
+            {
+                std::size_t offset = (std::size_t)rect.y * stride + (std::size_t)rect.x * texture.texelBytes;
+                if (rect.width == width)
+                    std::memcpy(mapped + offset, source + offset, (std::size_t)rect.height * stride);
+                else
+                    for (int y = 0; y < rect.height; y++, offset += stride)
+                        std::memcpy(mapped + offset, source + offset, (std::size_t)rect.width * texture.texelBytes);
+            }
+        }
+        // Unmapping fails if the buffer was lost, e.g. to a mode switch, the frame is dropped then
+        if (!mapped || !m_Upload->Unmap())
+        {
+            m_Upload->UnBind();
+            return false;
+        }
+        // Data pointers are offsets into the bound buffer now
+        pixels = m_Upload->GetOffset();
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    glBindTexture(GL_TEXTURE_2D, texture.id);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, width);
+    for (const UploadRect& rect : m_Rects)
+    {
+        std::uintptr_t offset = ((std::uintptr_t)rect.y * width + rect.x) * texture.texelBytes;
+        glTexSubImage2D(GL_TEXTURE_2D, 0, rect.textureX, rect.textureY, rect.width, rect.height, texture.format,
+                        texture.type, (const void*)(pixels + offset));
+        m_Stats.uploadBytes += (uint64_t)rect.width * rect.height * texture.texelBytes;
+    }
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    m_Stats.uploadRects += m_Rects.size();
+    m_Stats.submitMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    if (m_Upload)
+    {
+        m_Upload->Fence();
+        m_Upload->UnBind();
+        m_Stats.waitMs = m_Upload->GetWaitMs();
+    }
+    return true;
+}
+
+// Blocks of the pyramid level where a block is the smallest it can be and
+// still cover a whole pixel, so each pixel shows the density under it rather
+// than whichever cell it happens to land on
+void CellRenderer::DrawDensity(const Hashlife& life, FrameTimers& timers, int viewportWidth, int viewportHeight)
+{
+    unsigned int level = (unsigned int)std::max(1.0, std::ceil(std::log2(1.0 / m_CellSize) - 1e-9));
+    double blockCells = std::ldexp(1.0, (int)level);
+    double blockPixels = m_CellSize * blockCells;
+    double viewLeft = (m_CentreX - viewportWidth / (2.0 * m_CellSize)) / blockCells;
+    double viewTop = (m_CentreY - viewportHeight / (2.0 * m_CellSize)) / blockCells;
+    int64_t left = (int64_t)std::floor(viewLeft);
+    int64_t top = (int64_t)std::floor(viewTop);
+    int width = (int)((int64_t)std::floor(viewLeft + viewportWidth / blockPixels) + 1 - left);
+    int height = (int)((int64_t)std::floor(viewTop + viewportHeight / blockPixels) + 1 - top);
+
+    auto start = std::chrono::steady_clock::now();
+    m_Density.resize((std::size_t)width * height);
+    m_Pyramid.ReadLevel(life, level, left, top, width, height, m_Density.data(), (std::size_t)width);
+    m_Stats.pendingBlocks += m_Pyramid.GetPendingBlocks();
+    m_Rects.assign(1, { 0, 0, width, height, 0, 0 });
+    m_Stats.fillMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    glBeginQuery(GL_TIME_ELAPSED, timers.upload);
+    if (width != m_DensityTexture.width || height != m_DensityTexture.height)
+        Allocate(m_DensityTexture, width, height);
+    bool uploaded = Upload(m_DensityTexture, m_Density.data(), width, height);
+    glEndQuery(GL_TIME_ELAPSED);
+    if (!uploaded)
+        return;
+
+    m_DensityProgram.Bind();
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, m_DensityTexture.id);
+    m_DensityProgram.SetUniform1i("u_Density", 0);
+    m_DensityProgram.SetUniform2f("u_Origin", (float)(viewLeft - (double)left), (float)(viewTop - (double)top));
+    m_DensityProgram.SetUniform1f("u_BlockSize", (float)blockPixels);
+    m_DensityProgram.SetUniform1f("u_ViewportHeight", (float)viewportHeight);
+
+    glBindVertexArray(m_VertexArray);
+    glBeginQuery(GL_TIME_ELAPSED, timers.draw);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glEndQuery(GL_TIME_ELAPSED);
+    timers.pending = true;
+    m_Stats.frames++;
+    m_Stats.densityFrames++;
+}
+
+// Grows the page texture to hold `pages` with room to pan, or as many as fit
+// in the largest texture. Everything resident is dropped.
+void CellRenderer::ReservePages(unsigned int pages)
+{
+    unsigned int limit = (unsigned int)(m_MaxTextureSize / PageCache::PageRows) * PagesAcross;
+    unsigned int capacity = std::max(InitialPages, pages + pages / 2);
+    capacity = std::min((capacity + PagesAcross - 1) / PagesAcross * PagesAcross, limit);
+    if (capacity <= m_Pages.GetCapacity())
+        return;
+    Allocate(m_PageTexture, PagesAcross * PageCache::PageWords, capacity / PagesAcross * PageCache::PageRows);
+    m_Pages.Reset(capacity);
+}
+
+uint64_t CellRenderer::CountLive() const
+{
+    uint64_t live = 0;
+    for (uint32_t word : m_Words)
+        live += (uint64_t)__builtin_popcount(word);
+    return live;
+}
+
+// One instance per live cell of m_Words, lowest bit first, 64 cells at a time
+void CellRenderer::BuildInstances(const uint32_t* words, int width, int height, CellInstance* instance)
+{
+    for (int y = 0; y < height; y++)
+    {
+        const uint32_t* row = words + (std::size_t)y * width;
+        for (int x = 0; x < width; x += 2)
+        {
+            uint64_t bits = row[x];
+            if (x + 1 < width)
+                bits |= (uint64_t)row[x + 1] << 32;
+            while (bits)
+            {
+                *instance++ = { (int16_t)(x * 32 + __builtin_ctzll(bits)), (int16_t)y };
+                bits &= bits - 1;
+            }
+        }
+    }
+}
+
+bool CellRenderer::DrawInstanced(FrameTimers& timers, uint64_t count, int width, int height, float originX,
+                                 float originY, int viewportWidth, int viewportHeight)
+{
+    glBeginQuery(GL_TIME_ELAPSED, timers.upload);
+    CellInstance* instances = nullptr;
+    if (count)
+    {
+        instances = (CellInstance*)m_Instances->Map(count * sizeof(CellInstance));
+        if (instances)
+            BuildInstances(m_Words.data(), width, height, instances);
+        // A lost buffer drops the frame like a lost texture upload
+        if (!instances || !m_Instances->Unmap())
+        {
+            m_Instances->UnBind();
+            glEndQuery(GL_TIME_ELAPSED);
+            return false;
+        }
+        m_Stats.uploadBytes += count * sizeof(CellInstance);
+    }
+    glEndQuery(GL_TIME_ELAPSED);
+
+    glClearColor(DeadColor[0], DeadColor[1], DeadColor[2], DeadColor[3]);
+    glClear(GL_COLOR_BUFFER_BIT);
+    m_InstancedProgram.Bind();
+    m_InstancedProgram.SetUniform2f("u_Origin", originX, originY);
+    m_InstancedProgram.SetUniform1f("u_CellSize", (float)m_CellSize);
+    m_InstancedProgram.SetUniform2f("u_ViewportSize", (float)viewportWidth, (float)viewportHeight);
+
+    glBeginQuery(GL_TIME_ELAPSED, timers.draw);
+    if (count)
+    {
+        glBindVertexArray(m_QuadArray);
+        // The stream buffer is still bound, the segment moves every frame
+        glVertexAttribIPointer(1, 2, GL_SHORT, sizeof(CellInstance), (const void*)m_Instances->GetOffset());
+        glDrawElementsInstanced(GL_TRIANGLES, (int)m_QuadIndices->GetCount(), GL_UNSIGNED_INT, nullptr, (int)count);
+        m_Instances->Fence();
+        m_Instances->UnBind();
+        glBindVertexArray(0);
+    }
+    glEndQuery(GL_TIME_ELAPSED);
+    timers.pending = true;
+    m_Stats.frames++;
+    m_Stats.instancedFrames++;
+    m_Stats.instances += count;
+    return true;
+}
+
+// Adds up a finished frame's GPU times, a frame whose results aren't in yet is left out
+void CellRenderer::ReadTimers(FrameTimers& timers)
+{
+    if (!timers.pending)
+        return;
+    timers.pending = false;
+    int uploadReady = 0, drawReady = 0;
+    glGetQueryObjectiv(timers.upload, GL_QUERY_RESULT_AVAILABLE, &uploadReady);
+    glGetQueryObjectiv(timers.draw, GL_QUERY_RESULT_AVAILABLE, &drawReady);
+    if (!uploadReady || !drawReady)
+        return;
+
+    GLuint64 upload = 0, draw = 0;
+    glGetQueryObjectui64v(timers.upload, GL_QUERY_RESULT, &upload);
+    glGetQueryObjectui64v(timers.draw, GL_QUERY_RESULT, &draw);
+    m_Stats.gpuUploadMs += upload / 1e6;
+    m_Stats.gpuDrawMs += draw / 1e6;
+    m_Stats.timedFrames++;
+}
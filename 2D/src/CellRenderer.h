@@ -0,0 +1,185 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "DensityPyramid.h"
+#include "PageCache.h"
+#include "StreamBuffer.h"
+
+class Hashlife;
+class IndexBuffer;
+class Shader;
+class VertexBuffer;
+
+struct RenderStats
+{
+    uint64_t frames = 0;
+    uint64_t uploadBytes = 0;
+    uint64_t uploadRects = 0;    // texture updates, one per page sent and one per density level
+    uint64_t evictions = 0;      // pages dropped from the page cache to make room
+    uint64_t instancedFrames = 0;   // sparse frames drawn as one quad per live cell
+    uint64_t instances = 0;
+    uint64_t densityFrames = 0;     // zoomed out frames drawn from the density pyramid
+    uint64_t pendingBlocks = 0;     // of those, blocks shown before their count was finished
+    double fillMs = 0.0;         // CPU, reading the cells in view out of the tree and finding the pages that changed
+    double submitMs = 0.0;       // CPU, inside the texture upload call, where a synchronous upload blocks
+    double waitMs = 0.0;         // CPU, waiting for the GPU to be done with an upload buffer segment
+    uint64_t timedFrames = 0;    // frames whose GPU timers have come back, the two below are over these
+    double gpuUploadMs = 0.0;    // GPU, copying the upload into the texture
+    double gpuDrawMs = 0.0;
+};
+
+/**
+ * Draws the cells in view from an R32UI texture holding 32 cells per texel,
+ * so an upload is a bit per cell and a frame is one draw call.
+ *
+ * The texture is virtual. The universe is cut into fixed pages of 512 x 64
+ * cells and the pages in view live in a physical page texture of a few
+ * thousand slots, which a PageCache hands out and takes back least recently
+ * used first. A small page table texture gives each page of the view its
+ * slot, or none when the page is empty. The visible rectangle, widened to
+ * whole pages, is read out of the tree as a bit raster and a single triangle
+ * covering the window is drawn. The fragment shader finds each pixel's page
+ * in the table, its texel in the page's slot and its cell in the texel's
+ * bits. The GPU holds a fixed amount whatever the size of the universe, and
+ * nothing but the page texture depends on the number of cells.
+ *
+ * A sparse view, fewer than one live cell in 64, is drawn as instanced quads
+ * instead: the set bits of the raster become packed 16-bit cell offsets from
+ * the raster's top left corner (the camera tile), one instance of the unit
+ * quad each. The view goes back to the texture above one live cell in 32.
+ * The pages keep what they held meanwhile, so coming back still only sends
+ * what changed.
+ *
+ * Zoomed out past a cell per pixel, cells would alias and the raster would
+ * be the size of the board. The view is drawn from a DensityPyramid instead,
+ * at the level where a block just covers a pixel, so the upload is one byte
+ * per block and about the size of the window at any zoom. Reading the level
+ * walks the tree from the root, culled to the view and stopped at blocks,
+ * so a frame costs O(pixels) however big the universe is.
+ *
+ * Only pages that aren't resident or whose cells changed are sent, each one
+ * texture update, so a mostly settled pattern costs upload bandwidth in
+ * proportion to its activity rather than to the window, and panning sends
+ * only the pages coming into view. A page panned away and back is still in
+ * its slot unless the cache needed the room.
+ *
+ * Uploads go through a StreamBuffer: the changed pages are copied into
+ * the next segment and the texture is updated from there, which returns at
+ * once and leaves the copy to the GPU. By the time the ring comes back around
+ * to a segment its copy is long done, so filling rarely waits. With no upload
+ * buffers the texture is updated from memory and the call blocks while the
+ * driver copies. GPU timer queries measure the upload and the draw, they are
+ * read a few frames late so they never stall either.
+ */
+class CellRenderer
+{
+public:
+    static constexpr unsigned int MaxUploadBuffers = 3;
+
+    // `program` is the cell texture shader pair, `instancedProgram` the live
+    // cell quad pair and `densityProgram` the zoomed out pair, see res/shaders.
+    // They have to outlive the renderer. `uploadBuffers` is the upload ring's
+    // segment count, up to MaxUploadBuffers, 0 for none.
+    CellRenderer(Shader& program, Shader& instancedProgram, Shader& densityProgram,
+                 unsigned int uploadBuffers = MaxUploadBuffers);
+    ~CellRenderer();
+
+    CellRenderer(const CellRenderer&) = delete;
+    CellRenderer& operator=(const CellRenderer&) = delete;
+
+    // Cell under the middle of the window and how many pixels wide a cell is,
+    // below 1 when zoomed out
+    void SetView(double centreX, double centreY, double cellSize);
+
+    void Draw(const Hashlife& life, int viewportWidth, int viewportHeight);
+
+    const RenderStats& GetStats() const { return m_Stats; }
+    // "persistent", "orphaned" (no GL 4.4) or "synchronous" (no upload buffers)
+    const char* GetUploadMode() const;
+
+private:
+    // Queries of a frame in flight, reused this many frames later
+    static constexpr unsigned int TimerLatency = 4;
+
+    struct FrameTimers
+    {
+        unsigned int upload = 0;
+        unsigned int draw = 0;
+        bool pending = false;
+    };
+
+    // Page texture slots to a row, and how many to start with (512 x 4096 texels, 8 MB)
+    static constexpr unsigned int PagesAcross = 32;
+    static constexpr unsigned int InitialPages = 2048;
+
+    // Live cells per cell, as 1 in this many, that switch to quads and back to the texture
+    static constexpr uint64_t InstancedDensity = 64;
+    static constexpr uint64_t TextureDensity = 32;
+    // Widest and tallest view instances can reach with 16-bit offsets
+    static constexpr int64_t MaxInstancedSpan = 32768;
+
+    struct CellInstance
+    {
+        int16_t x, y;
+    };
+
+    struct Texture
+    {
+        unsigned int id;
+        int width, height;              // as allocated, in texels
+        int internalFormat;
+        unsigned int format, type;
+        unsigned int texelBytes;
+    };
+
+    // In texels and rows, from (x, y) of the source image to (textureX, textureY)
+    struct UploadRect
+    {
+        int x, y, width, height;
+        int textureX, textureY;
+    };
+
+    Shader& m_Program;
+    unsigned int m_VertexArray;      // empty, the vertex shader makes its own positions
+    Texture m_PageTexture;
+    Texture m_PageTable;
+    PageCache m_Pages;
+    int m_MaxTextureSize;
+    std::vector<uint32_t> m_Words;            // this frame's raster
+    std::vector<uint32_t> m_Table;            // this frame's page table
+    std::vector<UploadRect> m_Rects;          // parts of the source image to send
+    std::unique_ptr<StreamBuffer> m_Upload;
+
+    Shader& m_InstancedProgram;
+    unsigned int m_QuadArray;
+    std::unique_ptr<VertexBuffer> m_QuadVertices;
+    std::unique_ptr<IndexBuffer> m_QuadIndices;
+    std::unique_ptr<StreamBuffer> m_Instances;
+    bool m_Instanced;
+
+    Shader& m_DensityProgram;
+    Texture m_DensityTexture;
+    DensityPyramid m_Pyramid;
+    std::vector<uint8_t> m_Density;
+
+    FrameTimers m_Timers[TimerLatency];
+    RenderStats m_Stats;
+
+    double m_CentreX;
+    double m_CentreY;
+    double m_CellSize;
+
+    static void Allocate(Texture& texture, int width, int height);
+    bool Upload(Texture& texture, const uint8_t* source, int width, int height);
+    void ReservePages(unsigned int pages);
+    void DrawDensity(const Hashlife& life, FrameTimers& timers, int viewportWidth, int viewportHeight);
+    uint64_t CountLive() const;
+    static void BuildInstances(const uint32_t* words, int width, int height, CellInstance* instance);
+    bool DrawInstanced(FrameTimers& timers, uint64_t count, int width, int height, float originX, float originY,
+                       int viewportWidth, int viewportHeight);
+    void ReadTimers(FrameTimers& timers);
+};
@@ -0,0 +1,95 @@
+#include "CellsFile.h"
+#include "ChunkedLoader.h"
+#include "Hashlife.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+// Calls line(begin, end) for every row of the chunk, without the line end
+template <typename Function>
+static void ForEachRow(const TextChunk& chunk, Function line)
+{
+    for (const char* p = chunk.begin; p < chunk.end;)
+    {
+        const char* end = (const char*)std::memchr(p, '\n', (std::size_t)(chunk.end - p));
+        const char* next = end ? end + 1 : chunk.end;
+        if (!end)
+            end = chunk.end;
+        if (end > p && end[-1] == '\r')
+            end--;
+        if (p == end || *p != '!')
+            line(p, end);
+        p = next;
+    }
+}
+
+static void Decode(const TextChunk& chunk, BandCollector& collector)
+{
+    int64_t left = collector.GetLeft();
+    ForEachRow(chunk, [&](const char* begin, const char* end)
+    {
+        for (const char* p = begin; p < end;)
+        {
+            if (*p != 'O' && *p != '*')
+            {
+                p++;
+                continue;
+            }
+            const char* run = p;
+            while (p < end && (*p == 'O' || *p == '*'))
+                p++;
+            collector.AddRun(left + (run - begin), (uint64_t)(p - run));
+        }
+        collector.EndRows(1);
+    });
+}
+
+bool LoadCells(const std::string& path, Hashlife& life)
+{
+    auto start = std::chrono::steady_clock::now();
+    MappedFile file;
+    if (!file.Open(path, false))
+    {
+        std::cerr << "Failed to open pattern file: " << path << std::endl;
+        return false;
+    }
+
+    ThreadPool pool(life.GetThreadCount());
+    std::vector<TextChunk> chunks = SplitText((const char*)file.GetData(), file.GetSize(), '\n');
+
+    // Centring needs the whole pattern's size, so this pass runs over the entire file first
+    std::vector<int64_t> widths(chunks.size(), 0);
+    pool.Run((unsigned int)chunks.size(), [&](unsigned int i)
+    {
+        ForEachRow(chunks[i], [&](const char* begin, const char* end)
+        {
+            widths[i] = std::max(widths[i], (int64_t)(end - begin));
+            chunks[i].rows++;
+        });
+    });
+    int64_t width = 0, height = 0;
+    for (std::size_t i = 0; i < chunks.size(); i++)
+    {
+        width = std::max(width, widths[i]);
+        height += (int64_t)chunks[i].rows;
+    }
+
+    int64_t left = 0, top = 0;
+    CentreOffsets(width, height, left, top);
+    if (!LoadChunks(life, pool, chunks, left, top, nullptr, Decode))
+    {
+        std::cerr << "Failed to load pattern: " << path << std::endl;
+        return false;
+    }
+
+    auto finish = std::chrono::steady_clock::now();
+    std::cout << "Loaded pattern: " << path << " in "
+              << std::chrono::duration<double, std::milli>(finish - start).count() << " ms on "
+              << pool.GetThreadCount() << " threads" << std::endl;
+    return true;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <string>
+
+class Hashlife;
+
+/**
+ * Plaintext patterns (.cells): one line per row, 'O' (or '*') alive and '.'
+ * dead, lines starting with '!' are comments.
+ *
+ * The mapped file is cut into chunks at line ends. A first pass counts each
+ * chunk's rows and its longest line, which gives every chunk its first row
+ * and the pattern's size, then the chunks decode in parallel like RLE does.
+ * A loaded pattern replaces the universe and is centred on the origin.
+ */
+bool LoadCells(const std::string& path, Hashlife& life);
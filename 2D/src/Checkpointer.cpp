@@ -0,0 +1,130 @@
+#include "Checkpointer.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+
+Checkpointer::Checkpointer(Hashlife& life, const std::string& path)
+    :m_Life(life), m_Path(path), m_IntervalGenerations(0), m_IntervalSeconds(0.0),
+     m_MaxSlowdown(DefaultMaxSlowdown), m_Running(false), m_StartGeneration(life.GetGeneration()),
+     m_StartTime(std::chrono::steady_clock::now()), m_Count(0), m_Failures(0), m_LastGeneration(0),
+     m_BytesPerSecond(0.0), m_LastSeconds(0.0)
+{
+}
+
+Checkpointer::~Checkpointer()
+{
+    Wait();
+}
+
+void Checkpointer::SetInterval(uint64_t generations, double seconds)
+{
+    m_IntervalGenerations = generations;
+    m_IntervalSeconds = seconds;
+}
+
+void Checkpointer::Poll()
+{
+    if (m_Running)
+        return;
+    uint64_t generations = m_Life.GetGeneration() - m_StartGeneration;
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_StartTime).count();
+    if ((m_IntervalGenerations && generations >= m_IntervalGenerations)
+        || (m_IntervalSeconds > 0.0 && seconds >= m_IntervalSeconds))
+        Start();
+}
+
+bool Checkpointer::Start()
+{
+    if (m_Running)
+        return false;
+    Wait();
+
+    // A stepper that leaves a core idle doesn't notice the writer at all,
+    // otherwise the writer gets its share of the stepper's cores
+    unsigned int cores = std::max(std::thread::hardware_concurrency(), 1u);
+    unsigned int stepperThreads = m_Life.GetThreadCount();
+    double duty = stepperThreads < cores ? 1.0 : std::min(1.0, m_MaxSlowdown * stepperThreads);
+
+    m_Progress.bytesWritten = 0;
+    m_Progress.fraction = 0.0;
+    auto busyStart = std::chrono::steady_clock::now();
+    m_Progress.pace = [this, duty, busyStart]() mutable
+    {
+        auto now = std::chrono::steady_clock::now();
+        auto rest = std::chrono::duration<double>(now - busyStart) * ((1.0 - duty) / duty);
+        auto until = now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(rest);
+        // Short naps so a stepper stuck behind the pin isn't kept waiting
+        while (std::chrono::steady_clock::now() < until && !m_Life.IsWaitingForUnpin())
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        busyStart = std::chrono::steady_clock::now();
+    };
+
+    m_StartGeneration = m_Life.GetGeneration();
+    m_StartTime = std::chrono::steady_clock::now();
+    m_Running = true;
+    m_Writer = std::thread(&Checkpointer::Write, this, m_Life.Pin());
+    return true;
+}
+
+void Checkpointer::Wait()
+{
+    if (m_Writer.joinable())
+        m_Writer.join();
+}
+
+void Checkpointer::Write(Hashlife::PinnedRoot tree)
+{
+    auto start = std::chrono::steady_clock::now();
+    std::string tempPath = m_Path + ".tmp";
+    bool saved = SaveMacrocell(tempPath, m_Life, tree, &m_Progress);
+    // The file is complete, the stepper can have its nodes back before the fsync
+    m_Life.Unpin();
+    bool ok = saved && Commit(tempPath);
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    uint64_t bytes = m_Progress.bytesWritten.load();
+    if (ok)
+    {
+        m_Count++;
+        m_LastGeneration = tree.generation;
+        m_LastSeconds = seconds;
+        m_BytesPerSecond = seconds > 0.0 ? (double)bytes / seconds : 0.0;
+        std::cout << "Checkpoint " << m_Path << " at generation " << tree.generation << ": "
+                  << bytes / 1024 << " KB in " << seconds << " s" << std::endl;
+    }
+    else
+    {
+        m_Failures++;
+        std::remove(tempPath.c_str());
+        std::cerr << "Failed to write checkpoint " << m_Path << std::endl;
+    }
+    m_Running = false;
+}
+
+bool Checkpointer::Commit(const std::string& tempPath)
+{
+    int fd = open(tempPath.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    bool synced = fsync(fd) == 0;
+    close(fd);
+    return synced && std::rename(tempPath.c_str(), m_Path.c_str()) == 0;
+}
+
+CheckpointStats Checkpointer::GetStats() const
+{
+    CheckpointStats stats;
+    stats.count = m_Count.load();
+    stats.failures = m_Failures.load();
+    stats.lastGeneration = m_LastGeneration.load();
+    stats.running = m_Running.load();
+    stats.progress = stats.running ? m_Progress.fraction.load() : 0.0;
+    stats.bytesWritten = stats.running ? m_Progress.bytesWritten.load() : 0;
+    stats.bytesPerSecond = m_BytesPerSecond.load();
+    stats.lastSeconds = m_LastSeconds.load();
+    return stats;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+#include "Hashlife.h"
+#include "MacrocellFile.h"
+
+struct CheckpointStats
+{
+    uint64_t count = 0;              // checkpoints finished
+    uint64_t failures = 0;
+    uint64_t lastGeneration = 0;     // generation of the last finished checkpoint
+    bool running = false;
+    double progress = 0.0;           // of the one being written, 0 to 1
+    uint64_t bytesWritten = 0;       // so far, for the one being written
+    double bytesPerSecond = 0.0;     // write rate of the last finished one
+    double lastSeconds = 0.0;        // wall time of the last finished one, fsync included
+};
+
+/**
+ * Periodic checkpoints written by a background thread while the simulation
+ * keeps stepping.
+ *
+ * Starting one pins the current root, which costs nothing: nodes are never
+ * changed once created, so the pinned tree is a consistent generation for as
+ * long as it is pinned. The writer saves it as Macrocell to `<path>.tmp`,
+ * fsyncs and renames it over the last checkpoint.
+ *
+ * The writer paces itself so it takes at most `maxSlowdown` of the CPU time
+ * the stepper uses. It only runs flat out when the stepper has to wait for
+ * it, i.e. when a collection is due while the tree is still pinned.
+ */
+class Checkpointer
+{
+public:
+    static constexpr double DefaultMaxSlowdown = 0.03;
+
+    Checkpointer(Hashlife& life, const std::string& path);
+    ~Checkpointer();
+
+    Checkpointer(const Checkpointer&) = delete;
+    Checkpointer& operator=(const Checkpointer&) = delete;
+
+    // 0 turns that trigger off
+    void SetInterval(uint64_t generations, double seconds);
+    void SetMaxSlowdown(double maxSlowdown) { m_MaxSlowdown = maxSlowdown; }
+
+    // Call between steps, starts a checkpoint when one is due
+    void Poll();
+    // Starts one now unless one is still being written
+    bool Start();
+    void Wait();
+
+    CheckpointStats GetStats() const;
+
+private:
+    Hashlife& m_Life;
+    std::string m_Path;
+    uint64_t m_IntervalGenerations;
+    double m_IntervalSeconds;
+    double m_MaxSlowdown;
+
+    std::thread m_Writer;
+    std::atomic<bool> m_Running;
+    SaveProgress m_Progress;
+    uint64_t m_StartGeneration;
+    std::chrono::steady_clock::time_point m_StartTime;
+
+    std::atomic<uint64_t> m_Count;
+    std::atomic<uint64_t> m_Failures;
+    std::atomic<uint64_t> m_LastGeneration;
+    std::atomic<double> m_BytesPerSecond;
+    std::atomic<double> m_LastSeconds;
+
+    void Write(Hashlife::PinnedRoot tree);
+    bool Commit(const std::string& tempPath);
+};
@@ -0,0 +1,197 @@
+#include "ChunkedLoader.h"
+#include "Hashlife.h"
+#include "ThreadPool.h"
+
+#include <cstring>
+#include <iostream>
+
+static const unsigned int ChunksPerThread = 4;
+
+void MergeLeaves(const std::vector<PatternLeaf>& a, const std::vector<PatternLeaf>& b, unsigned int shift,
+                 std::vector<PatternLeaf>& result)
+{
+    result.clear();
+    std::size_t i = 0, j = 0;
+    while (i < a.size() || j < b.size())
+    {
+        if (j == b.size() || (i < a.size() && a[i].column < b[j].column))
+            result.push_back(a[i++]);
+        else if (i == a.size() || b[j].column < a[i].column)
+        {
+            result.push_back({ b[j].column, b[j].bits << shift });
+            j++;
+        }
+        else
+        {
+            result.push_back({ a[i].column, a[i].bits | (b[j].bits << shift) });
+            i++;
+            j++;
+        }
+    }
+}
+
+void BandCollector::MergeLine()
+{
+    if (m_Line.empty())
+        return;
+    // Rows come left to right so both lists are sorted
+    MergeLeaves(m_Band, m_Line, (unsigned int)(m_Row & 7) * 8, m_Merged);
+    m_Band.swap(m_Merged);
+    m_Line.clear();
+}
+
+void BandCollector::EndRows(uint64_t count)
+{
+    MergeLine();
+    int64_t band = m_Row >> 3;
+    m_Row += (int64_t)count;
+    if ((m_Row >> 3) != band && !m_Band.empty())
+    {
+        m_Bands.push_back({ band, std::move(m_Band), {} });
+        m_Band = std::vector<PatternLeaf>();
+    }
+}
+
+void BandCollector::Finish()
+{
+    MergeLine();
+    if (!m_Band.empty())
+    {
+        m_Bands.push_back({ m_Row >> 3, std::move(m_Band), {} });
+        m_Band = std::vector<PatternLeaf>();
+    }
+}
+
+void CentreOffsets(int64_t width, int64_t height, int64_t& left, int64_t& top)
+{
+    int64_t size = 8;
+    int64_t extent = std::max(width, height);
+    while (size < extent && size < ((int64_t)1 << 61))
+        size <<= 1;
+    left = width > 0 ? (size - width) / 2 : 0;
+    top = height > 0 ? (size - height) / 2 : 0;
+}
+
+bool PlaceOffsets(int64_t x, int64_t y, int64_t width, int64_t height, int64_t& left, int64_t& top,
+                  unsigned int& rootLevel)
+{
+    // Far enough inside int64 that the sums below can't overflow
+    const int64_t limit = (int64_t)1 << 60;
+    if (x < -limit || x > limit || y < -limit || y > limit || width > limit || height > limit)
+        return false;
+    int64_t extent = std::max({ (int64_t)8, -x, x + std::max(width, (int64_t)1), -y, y + std::max(height, (int64_t)1) });
+    rootLevel = Hashlife::LeafLevel + 1;
+    while (((int64_t)1 << (rootLevel - 1)) < extent)
+        rootLevel++;
+    int64_t half = (int64_t)1 << (rootLevel - 1);
+    left = x + half;
+    top = y + half;
+    return true;
+}
+
+std::vector<TextChunk> SplitText(const char* data, std::size_t size, char separator, std::size_t chunkSize)
+{
+    std::vector<TextChunk> chunks;
+    const char* end = data + size;
+    for (const char* p = data; p < end;)
+    {
+        const char* cut = end;
+        if ((std::size_t)(end - p) > chunkSize)
+        {
+            cut = (const char*)std::memchr(p + chunkSize, separator, (std::size_t)(end - p) - chunkSize);
+            cut = cut ? cut + 1 : end;
+        }
+        chunks.push_back({ p, cut });
+        p = cut;
+    }
+    return chunks;
+}
+
+bool LoadChunks(Hashlife& life, ThreadPool& pool, std::vector<TextChunk>& chunks, int64_t left, int64_t top,
+                const std::function<void(TextChunk&)>& countRows,
+                const std::function<void(const TextChunk&, BandCollector&)>& decode, uint64_t generation,
+                unsigned int rootLevel)
+{
+    PatternBuilder builder(life);
+    builder.SetRootLevel(rootLevel);
+    std::size_t window = (std::size_t)pool.GetThreadCount() * ChunksPerThread;
+    std::vector<BandCollector> collectors;
+    BandCollector::Band carry = { 0, {}, {} };     // last band so far, the next chunk may add to it
+    bool hasCarry = false;
+    std::vector<PatternLeaf> merged;
+    int64_t row = top;
+    bool ok = true;
+    bool done = false;
+
+    for (std::size_t first = 0; ok && !done && first < chunks.size(); first += window)
+    {
+        std::size_t count = std::min(window, chunks.size() - first);
+        if (countRows)
+            pool.Run((unsigned int)count, [&](unsigned int i) { countRows(chunks[first + i]); });
+
+        collectors.clear();
+        for (std::size_t i = 0; i < count && !done; i++)
+        {
+            collectors.emplace_back(left, row);
+            row += (int64_t)chunks[first + i].rows;
+            done = chunks[first + i].last;
+        }
+        pool.Run((unsigned int)collectors.size(), [&](unsigned int i)
+        {
+            decode(chunks[first + i], collectors[i]);
+            collectors[i].Finish();
+        });
+
+        // A band cut by a chunk boundary goes back together in the later chunk
+        BandCollector::Band* previous = hasCarry ? &carry : nullptr;
+        for (BandCollector& collector : collectors)
+        {
+            std::vector<BandCollector::Band>& bands = collector.GetBands();
+            if (bands.empty())
+                continue;
+            if (previous && previous->band == bands.front().band)
+            {
+                MergeLeaves(previous->leaves, bands.front().leaves, 0, merged);
+                bands.front().leaves.swap(merged);
+                previous->leaves.clear();
+            }
+            previous = &bands.back();
+        }
+        if (hasCarry && !carry.leaves.empty())
+            ok = builder.AddBand(carry.band, carry.leaves);
+        hasCarry = false;
+
+        // The last band waits for the next window
+        for (std::size_t i = collectors.size(); i-- > 0;)
+        {
+            std::vector<BandCollector::Band>& bands = collectors[i].GetBands();
+            if (bands.empty())
+                continue;
+            carry = std::move(bands.back());
+            bands.pop_back();
+            hasCarry = true;
+            break;
+        }
+
+        // Leaves of all bands that are complete now, hash-consed on every thread
+        pool.Run((unsigned int)collectors.size(), [&](unsigned int i)
+        {
+            for (BandCollector::Band& band : collectors[i].GetBands())
+            {
+                band.nodes.resize(band.leaves.size());
+                for (std::size_t j = 0; j < band.leaves.size(); j++)
+                    band.nodes[j] = life.MakeLeaf(band.leaves[j].bits);
+            }
+        });
+        for (BandCollector& collector : collectors)
+            for (BandCollector::Band& band : collector.GetBands())
+                if (ok && !band.leaves.empty())
+                    ok = builder.AddBand(band.band, band.leaves, band.nodes.data());
+    }
+
+    if (ok && hasCarry && !carry.leaves.empty())
+        ok = builder.AddBand(carry.band, carry.leaves);
+    if (!builder.Finish(generation))
+        return false;
+    return ok;
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "PatternBuilder.h"
+
+class Hashlife;
+class ThreadPool;
+
+// A piece of a text pattern that starts at the beginning of a row
+struct TextChunk
+{
+    const char* begin;
+    const char* end;
+    uint64_t rows = 0;       // how far the piece moves down, filled in by the first pass
+    bool last = false;       // the pattern ends in this piece, the ones after it are ignored
+};
+
+/**
+ * Collects runs of live cells, given row by row from top to bottom, into
+ * bands of leaves. Every chunk of a file decodes into its own collector
+ * starting at the chunk's first row, so chunks don't depend on each other.
+ */
+class BandCollector
+{
+public:
+    struct Band
+    {
+        int64_t band;
+        std::vector<PatternLeaf> leaves;
+        std::vector<uint32_t> nodes;      // the leaves made in the engine, once they are
+    };
+
+    BandCollector(int64_t left, int64_t row)
+        : m_Left(left), m_Row(row)
+    {
+    }
+
+    // Builder column where every row starts
+    int64_t GetLeft() const { return m_Left; }
+
+    void AddRun(int64_t x, uint64_t length);
+    // Ends the current row and skips `count` - 1 empty ones
+    void EndRows(uint64_t count);
+    void Finish();
+
+    std::vector<Band>& GetBands() { return m_Bands; }
+
+private:
+    int64_t m_Left;
+    int64_t m_Row;
+    std::vector<PatternLeaf> m_Line;      // one row, each leaf's cells in its low byte
+    std::vector<PatternLeaf> m_Band;      // rows of the current band merged so far
+    std::vector<PatternLeaf> m_Merged;
+    std::vector<Band> m_Bands;
+
+    void MergeLine();
+};
+
+inline void BandCollector::AddRun(int64_t x, uint64_t length)
+{
+    while (length)
+    {
+        int64_t column = x >> 3;
+        unsigned int shift = (unsigned int)(x & 7);
+        unsigned int cells = (unsigned int)std::min<uint64_t>(length, 8 - shift);
+        uint64_t bits = ((0xFFu >> (8 - cells)) << shift) & 0xFF;
+        if (!m_Line.empty() && m_Line.back().column == column)
+            m_Line.back().bits |= bits;
+        else
+            m_Line.push_back({ column, bits });
+        x += cells;
+        length -= cells;
+    }
+}
+
+// ORs two column sorted leaf lists, `b` shifted up by `shift` bits
+void MergeLeaves(const std::vector<PatternLeaf>& a, const std::vector<PatternLeaf>& b, unsigned int shift,
+                 std::vector<PatternLeaf>& result);
+
+// Puts a width x height pattern in the middle of its power of two square,
+// the builder centres that square on the origin
+void CentreOffsets(int64_t width, int64_t height, int64_t& left, int64_t& top);
+// Puts a width x height pattern with its top left cell at (x, y) of the
+// universe, `rootLevel` is the level to build it under (see
+// PatternBuilder::SetRootLevel). False if that's too far out to build.
+bool PlaceOffsets(int64_t x, int64_t y, int64_t width, int64_t height, int64_t& left, int64_t& top,
+                  unsigned int& rootLevel);
+
+// Cuts text into pieces of about `chunkSize` bytes, every cut just after a `separator`
+std::vector<TextChunk> SplitText(const char* data, std::size_t size, char separator,
+                                 std::size_t chunkSize = (std::size_t)4 << 20);
+
+/**
+ * Parallel load of a text pattern that was split at row boundaries.
+ *
+ * `countRows` is the first pass, it fills in every chunk's row count (and
+ * may cut the chunk short and mark it last). Leave it empty if the chunks
+ * already carry their counts. A running sum of the counts gives each chunk
+ * its first row, then `decode` turns every chunk into bands on its own.
+ * Bands split by a chunk boundary are ORed back together, their leaves are
+ * made in the engine on all threads and the bands go to a PatternBuilder in
+ * order. The universe starts at `generation`, `rootLevel` fixes the root
+ * as PatternBuilder::SetRootLevel does (0 leaves it to the pattern).
+ *
+ * The file goes through a few chunks per thread at a time, so only that
+ * much of it is ever decoded at once.
+ */
+bool LoadChunks(Hashlife& life, ThreadPool& pool, std::vector<TextChunk>& chunks, int64_t left, int64_t top,
+                const std::function<void(TextChunk&)>& countRows,
+                const std::function<void(const TextChunk&, BandCollector&)>& decode, uint64_t generation = 0,
+                unsigned int rootLevel = 0);
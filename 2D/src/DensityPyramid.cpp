@@ -0,0 +1,153 @@
+#include "DensityPyramid.h"
+#include "Hashlife.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// Empty stays 0 and any live cell shows, the rest is linear in the live fraction
+static uint8_t Density(uint64_t count, unsigned int level)
+{
+    if (!count)
+        return 0;
+    double fraction = std::ldexp((double)count, -2 * (int)level);
+    return (uint8_t)std::max(1.0, std::min(255.0, std::round(fraction * 255.0)));
+}
+
+void DensityPyramid::ReadLevel(const Hashlife& life, unsigned int level, int64_t left, int64_t top, int width,
+                               int height, uint8_t* density, std::size_t stride)
+{
+    if (life.GetNodeVersion() != m_NodeVersion || m_Counts.size() > MaxCachedCounts)
+    {
+        m_Counts.clear();
+        m_NodeVersion = life.GetNodeVersion();
+    }
+    m_Budget = CountsPerRead;
+    m_Pending = 0;
+    for (int y = 0; y < height; y++)
+        std::memset(density + (std::size_t)y * stride, 0, (std::size_t)width);
+
+    if (width <= 0 || height <= 0)
+        return;
+    // The root straddles the origin, its quadrants are aligned like every node below them
+    Region region = { level, left, top, left + width, top + height, density, stride };
+    unsigned int rootLevel = life.GetRootLevel();
+    int64_t half = (int64_t)1 << (rootLevel - 1);
+    uint32_t quadrants[4];
+    life.GetChildren(life.GetRoot(), quadrants);
+    ReadNode(life, quadrants[0], rootLevel - 1, -half, -half, region);
+    ReadNode(life, quadrants[1], rootLevel - 1, 0, -half, region);
+    ReadNode(life, quadrants[2], rootLevel - 1, -half, 0, region);
+    ReadNode(life, quadrants[3], rootLevel - 1, 0, 0, region);
+}
+
+// False if the count needs more new counts than the budget has left. Finished
+// subtrees are kept anyway, so the next read carries on from there.
+bool DensityPyramid::Population(const Hashlife& life, uint32_t node, unsigned int level, uint64_t& population)
+{
+    if (level == Hashlife::LeafLevel)
+    {
+        population = (uint64_t)__builtin_popcountll(life.GetLeafBits(node));
+        return true;
+    }
+    if (node == life.EmptyNode(level))
+    {
+        population = 0;
+        return true;
+    }
+
+    auto it = m_Counts.find(node);
+    if (it != m_Counts.end())
+    {
+        population = it->second;
+        return true;
+    }
+    if (!m_Budget)
+        return false;
+
+    uint32_t children[4];
+    life.GetChildren(node, children);
+    uint64_t total = 0;
+    bool known = true;
+    for (uint32_t child : children)
+    {
+        uint64_t count = 0;
+        known = Population(life, child, level - 1, count) && known;
+        total += count;
+    }
+    if (!known || !m_Budget)
+        return false;
+    m_Budget--;
+    m_Counts.emplace(node, total);
+    population = total;
+    return true;
+}
+
+// (x, y) is the node's top left cell
+void DensityPyramid::ReadNode(const Hashlife& life, uint32_t node, unsigned int level, int64_t x, int64_t y,
+                              const Region& region)
+{
+    if (node == life.EmptyNode(level))
+        return;
+
+    // Blocks the node covers, at least one
+    int64_t shift = level > region.level ? level - region.level : 0;
+    int64_t blockX = x >> region.level;
+    int64_t blockY = y >> region.level;
+    int64_t size = (int64_t)1 << shift;
+    if (blockX + size <= region.left || blockX >= region.right || blockY + size <= region.top ||
+        blockY >= region.bottom)
+        return;
+
+    // A node no bigger than a block lies inside one
+    if (level <= region.level)
+    {
+        uint64_t population = 0;
+        uint8_t density = 1;
+        if (Population(life, node, level, population))
+            density = Density(population, region.level);
+        else
+            m_Pending++;
+        region.density[(std::size_t)(blockY - region.top) * region.stride + (std::size_t)(blockX - region.left)] =
+            density;
+        return;
+    }
+    if (level == Hashlife::LeafLevel)
+    {
+        ReadLeaf(life.GetLeafBits(node), x, y, region);
+        return;
+    }
+
+    uint32_t children[4];
+    life.GetChildren(node, children);
+    int64_t half = (int64_t)1 << (level - 1);
+    ReadNode(life, children[0], level - 1, x, y, region);
+    ReadNode(life, children[1], level - 1, x + half, y, region);
+    ReadNode(life, children[2], level - 1, x, y + half, region);
+    ReadNode(life, children[3], level - 1, x + half, y + half, region);
+}
+
+// Blocks of 2x2 or 4x4 cells, row r of the leaf is byte r and column c bit c
+void DensityPyramid::ReadLeaf(uint64_t bits, int64_t x, int64_t y, const Region& region)
+{
+    unsigned int side = 1u << region.level;
+    uint64_t rowMask = (1u << side) - 1;
+    uint64_t blockMask = 0;
+    for (unsigned int row = 0; row < side; row++)
+        blockMask |= rowMask << (row * 8);
+
+    for (unsigned int by = 0; by < 8; by += side)
+    {
+        int64_t blockY = ((y + by) >> region.level) - region.top;
+        if (blockY < 0 || blockY >= region.bottom - region.top)
+            continue;
+        for (unsigned int bx = 0; bx < 8; bx += side)
+        {
+            int64_t blockX = ((x + bx) >> region.level) - region.left;
+            if (blockX < 0 || blockX >= region.right - region.left)
+                continue;
+            uint64_t count = (uint64_t)__builtin_popcountll(bits & (blockMask << (by * 8 + bx)));
+            region.density[(std::size_t)blockY * region.stride + (std::size_t)blockX] = Density(count, region.level);
+        }
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+class Hashlife;
+
+/**
+ * Live cell counts in power-of-two blocks, for drawing views zoomed out past
+ * a cell per pixel.
+ *
+ * Level k of the pyramid counts 2^k x 2^k blocks. From the leaf level up a
+ * block is exactly one tree node, so the pyramid is the engine's own quadtree
+ * with a population on every node. Populations are kept across frames keyed
+ * by node. A step builds new nodes only where the pattern changed and the
+ * rest keep their index, so each frame only counts the parts that changed
+ * since the last one. Blocks smaller than a leaf are counted from its bits.
+ *
+ * The walk starts at the root, skips empty nodes and nodes outside the view,
+ * and stops at blocks, which the renderer makes about a pixel, so it visits
+ * O(blocks) nodes however far the pattern reaches. Counting a block can mean
+ * walking a big subtree the first time though, e.g. after a load or a jump,
+ * so only a budget of new counts is made per frame. A block whose count isn't
+ * finished shows as barely alive and fills in over the next frames, the
+ * counts already made are kept so nothing is walked twice.
+ *
+ * The counts are dropped when the engine renumbers its nodes, and when they
+ * grow past a cap from nodes that are long gone.
+ */
+class DensityPyramid
+{
+public:
+    static constexpr std::size_t MaxCachedCounts = (std::size_t)1 << 22;
+    static constexpr uint64_t CountsPerRead = (uint64_t)1 << 18;
+
+    // Fills the width x height blocks of level `level` starting at block
+    // (left, top) with their density: 0 for empty, otherwise 1 to 255 in
+    // proportion to the live fraction. Rows are `stride` bytes apart.
+    void ReadLevel(const Hashlife& life, unsigned int level, int64_t left, int64_t top, int width, int height,
+                   uint8_t* density, std::size_t stride);
+
+    // Blocks of the last read shown before their count was finished
+    uint64_t GetPendingBlocks() const { return m_Pending; }
+
+private:
+    struct Region
+    {
+        unsigned int level;
+        int64_t left, top, right, bottom;    // in blocks
+        uint8_t* density;
+        std::size_t stride;
+    };
+
+    std::unordered_map<uint32_t, uint64_t> m_Counts;
+    uint64_t m_NodeVersion = ~(uint64_t)0;
+    uint64_t m_Budget = 0;          // new counts left in this read
+    uint64_t m_Pending = 0;
+
+    bool Population(const Hashlife& life, uint32_t node, unsigned int level, uint64_t& population);
+    void ReadNode(const Hashlife& life, uint32_t node, unsigned int level, int64_t x, int64_t y, const Region& region);
+    void ReadLeaf(uint64_t bits, int64_t x, int64_t y, const Region& region);
+};
@@ -0,0 +1,164 @@
+#include "GenerationStream.h"
+#include "Hashlife.h"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+static_assert(sizeof(PatternTile) == 24, "tiles are written as they sit in memory");
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "the stream is little endian");
+
+static const char StreamMagic[4] = { 'G', 'O', 'L', 'S' };
+static const uint8_t StreamVersion = 1;
+
+GenerationStream::GenerationStream()
+    :m_FileDescriptor(-1), m_OwnsDescriptor(false), m_FullInterval(DefaultFullInterval), m_SinceFull(0),
+     m_HasLast(false), m_LastGeneration(0), m_FrameCount(0), m_PendingBytes(0)
+{
+}
+
+GenerationStream::~GenerationStream()
+{
+    Close();
+}
+
+bool GenerationStream::Open(const std::string& path, unsigned int fullInterval)
+{
+    Close();
+    if (path == "-")
+        m_FileDescriptor = STDOUT_FILENO;
+    else
+    {
+        // Also works for a named pipe, this waits until a reader opens it
+        m_FileDescriptor = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (m_FileDescriptor < 0)
+        {
+            std::cerr << "Failed to open stream " << path << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        m_OwnsDescriptor = true;
+    }
+    // A reader going away shows up as EPIPE instead of killing the process
+    signal(SIGPIPE, SIG_IGN);
+
+    m_FullInterval = fullInterval;
+    m_SinceFull = 0;
+    m_HasLast = false;
+    m_Last.clear();
+    return true;
+}
+
+void GenerationStream::Close()
+{
+    if (m_FileDescriptor < 0)
+        return;
+    Flush();
+    if (m_OwnsDescriptor)
+        close(m_FileDescriptor);
+    m_FileDescriptor = -1;
+    m_OwnsDescriptor = false;
+}
+
+bool GenerationStream::Write(const Hashlife& life)
+{
+    if (m_FileDescriptor < 0)
+        return false;
+    uint64_t generation = life.GetGeneration();
+    // Nothing new, so a paused run doesn't leave what's queued sitting there
+    if (m_HasLast && generation == m_LastGeneration)
+        return Flush();
+
+    CaptureTiles(life, m_Current);
+    Frame& frame = m_Frames[m_FrameCount++];
+    bool full = !m_HasLast || (m_FullInterval && ++m_SinceFull >= m_FullInterval);
+    if (full)
+    {
+        frame.tiles.assign(m_Current.begin(), m_Current.end());
+        m_SinceFull = 0;
+        m_Stats.fullFrames++;
+    }
+    else
+        XorTiles(m_Last, m_Current, frame.tiles);
+    m_Last.swap(m_Current);
+    m_LastGeneration = generation;
+    m_HasLast = true;
+
+    FrameHeader& header = frame.header;
+    std::memcpy(header.magic, StreamMagic, sizeof(StreamMagic));
+    header.version = StreamVersion;
+    header.type = full ? 1 : 0;
+    header.tileSize = sizeof(PatternTile);
+    header.generation = generation;
+    header.tileCount = frame.tiles.size();
+    m_PendingBytes += sizeof(FrameHeader) + frame.tiles.size() * sizeof(PatternTile);
+    m_Stats.frames++;
+    m_Stats.tiles += frame.tiles.size();
+
+    if (m_FrameCount == BatchFrames || m_PendingBytes >= BatchBytes)
+        return Flush();
+    return true;
+}
+
+bool GenerationStream::Flush()
+{
+    if (m_FileDescriptor < 0 || m_FrameCount == 0)
+        return m_FileDescriptor >= 0;
+
+    int count = 0;
+    for (unsigned int i = 0; i < m_FrameCount; i++)
+    {
+        Frame& frame = m_Frames[i];
+        m_Vectors[count++] = { &frame.header, sizeof(FrameHeader) };
+        if (!frame.tiles.empty())
+            m_Vectors[count++] = { frame.tiles.data(), frame.tiles.size() * sizeof(PatternTile) };
+    }
+
+    // A pipe takes what fits, the rest goes in later calls
+    auto start = std::chrono::steady_clock::now();
+    iovec* vectors = m_Vectors;
+    bool ok = true;
+    while (count > 0)
+    {
+        ssize_t written = writev(m_FileDescriptor, vectors, count);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            std::cerr << "Stream closed: " << std::strerror(errno) << std::endl;
+            ok = false;
+            break;
+        }
+        m_Stats.writes++;
+        m_Stats.bytes += (uint64_t)written;
+        std::size_t left = (std::size_t)written;
+        while (count > 0 && left >= vectors->iov_len)
+        {
+            left -= vectors->iov_len;
+            vectors++;
+            count--;
+        }
+        if (count > 0)
+        {
+            vectors->iov_base = (char*)vectors->iov_base + left;
+            vectors->iov_len -= left;
+        }
+    }
+    m_Stats.writeMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    m_FrameCount = 0;
+    m_PendingBytes = 0;
+    if (!ok)
+    {
+        // Later deltas would be meaningless without the frames that were lost
+        if (m_OwnsDescriptor)
+            close(m_FileDescriptor);
+        m_FileDescriptor = -1;
+        m_OwnsDescriptor = false;
+    }
+    return ok;
+}
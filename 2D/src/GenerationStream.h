@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <sys/uio.h>
+
+#include "PatternTiles.h"
+
+class Hashlife;
+
+struct GenerationStreamStats
+{
+    uint64_t frames = 0;
+    uint64_t fullFrames = 0;
+    uint64_t tiles = 0;
+    uint64_t bytes = 0;
+    uint64_t writes = 0;         // writev calls, several frames go out in each
+    double writeMs = 0.0;        // time in writev, mostly waiting on a slow reader
+};
+
+/**
+ * Binary generation stream for other processes (--stream).
+ *
+ * Every frame is a 24 byte header followed by `tileCount` 24 byte tiles, all
+ * little endian:
+ *
+ *     char     magic[4]      "GOLS"
+ *     uint8_t  version       1
+ *     uint8_t  type          0 delta, 1 full
+ *     uint16_t tileSize      24
+ *     uint64_t generation
+ *     uint64_t tileCount
+ *
+ *     int64_t  column        x / 8
+ *     int64_t  band          y / 8
+ *     uint64_t bits          cell (x & 7, y & 7) is bit (y & 7) * 8 + (x & 7)
+ *
+ * A full frame lists every live 8x8 tile. A delta lists the tiles that
+ * changed since the previous frame, XORed with what they were. The first
+ * frame is always full, after that one every `fullInterval` frames (0 for
+ * never) so a reader can join late.
+ *
+ * Tiles go out straight from the arrays they were diffed in, frames are
+ * queued and written together with one writev. Tile arrays are recycled,
+ * so once they have grown to the pattern's size no frame allocates. Writes
+ * block while the reader is behind, which holds the simulation back rather
+ * than dropping frames a delta would depend on.
+ */
+class GenerationStream
+{
+public:
+    static constexpr unsigned int DefaultFullInterval = 600;
+
+    GenerationStream();
+    ~GenerationStream();
+
+    GenerationStream(const GenerationStream&) = delete;
+    GenerationStream& operator=(const GenerationStream&) = delete;
+
+    // "-" is stdout
+    bool Open(const std::string& path, unsigned int fullInterval = DefaultFullInterval);
+    void Close();
+    bool IsOpen() const { return m_FileDescriptor >= 0; }
+
+    // Queues a frame if the generation moved, writes the queue when it's full
+    // or when the generation stood still (paused) since the last frame
+    bool Write(const Hashlife& life);
+    bool Flush();
+
+    const GenerationStreamStats& GetStats() const { return m_Stats; }
+
+private:
+    struct FrameHeader
+    {
+        char magic[4];
+        uint8_t version;
+        uint8_t type;
+        uint16_t tileSize;
+        uint64_t generation;
+        uint64_t tileCount;
+    };
+    static_assert(sizeof(FrameHeader) == 24, "the header goes out as it is, no padding");
+
+    struct Frame
+    {
+        FrameHeader header;
+        std::vector<PatternTile> tiles;
+    };
+
+    static constexpr unsigned int BatchFrames = 16;
+    static constexpr std::size_t BatchBytes = (std::size_t)1 << 20;
+
+    int m_FileDescriptor;
+    bool m_OwnsDescriptor;
+    unsigned int m_FullInterval;
+    unsigned int m_SinceFull;
+    bool m_HasLast;
+    uint64_t m_LastGeneration;
+
+    std::vector<PatternTile> m_Last;      // live tiles as of the last frame
+    std::vector<PatternTile> m_Current;
+    Frame m_Frames[BatchFrames];
+    unsigned int m_FrameCount;
+    std::size_t m_PendingBytes;
+    iovec m_Vectors[BatchFrames * 2];
+
+    GenerationStreamStats m_Stats;
+};
@@ -0,0 +1,1288 @@
+#include "Hashlife.h"
+#include "LifeKernel.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <queue>
+#include <tuple>
+
+// Conway's B3/S23, one bit per neighbour count.
+static const unsigned int BirthMask = 1 << 3;
+static const unsigned int SurviveMask = (1 << 2) | (1 << 3);
+
+static const std::size_t MinCapacity = 1 << 12;
+
+// Leaf references carry the top bit so a level 4 node (four leaves) can never
+// hash-cons to the same key as a level 5 node (four nodes).
+static const uint32_t LeafBit = 0x80000000u;
+static const unsigned int MaxLevel = 63;
+static const uint64_t TagMask = 0xFFFFFFFF00000000ull;
+
+// Quadrants of a leaf bitmap
+static const uint64_t LeafNW = 0x000000000F0F0F0Full;
+static const uint64_t LeafNE = 0x00000000F0F0F0F0ull;
+static const uint64_t LeafSW = 0x0F0F0F0F00000000ull;
+static const uint64_t LeafSE = 0xF0F0F0F000000000ull;
+
+// Counters are kept per thread and flushed into the engine after each task,
+// bumping shared atomics on every lookup would bounce their cache line around.
+struct ThreadCounters
+{
+    uint64_t nodesCreated;
+    uint64_t resultHits;
+    uint64_t resultMisses;
+};
+static thread_local ThreadCounters s_Counters = {};
+
+struct Hashlife::MarkState
+{
+    std::vector<uint8_t> nodeLevel;     // 0 when unmarked, the node's level otherwise
+    std::vector<uint8_t> leafMarked;
+    std::vector<std::pair<uint32_t, uint8_t>> withResults;
+    uint64_t liveCount = 0;
+};
+
+static const char StoreMagic[8] = { 'H', 'L', 'S', 'T', 'O', 'R', 'E', 0 };
+static const uint32_t StoreVersion = 1;
+static const std::size_t StoreAlignment = 4096;
+
+// First page of the node store, every other region follows at a fixed offset
+struct Hashlife::StoreHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t nodeSize;
+    uint32_t birthMask;
+    uint32_t surviveMask;
+    uint64_t capacity;
+    uint64_t leafCapacity;
+    uint64_t nodeCount;
+    uint64_t leafCount;
+    uint64_t generation;
+    uint32_t root;
+    uint32_t rootLevel;
+    uint32_t stepLog2;
+    uint32_t epoch;
+    uint32_t clean;          // 0 while a run has the store open
+};
+
+struct Hashlife::StoreLayout
+{
+    std::size_t capacity;
+    std::size_t leafCapacity;
+    uint64_t nodeTableSize;
+    uint64_t leafTableSize;
+    std::size_t nodes;
+    std::size_t stepResult;
+    std::size_t lastUsed;
+    std::size_t leaves;
+    std::size_t nodeTable;
+    std::size_t leafTable;
+    std::size_t total;
+};
+
+static std::size_t AlignUp(std::size_t offset)
+{
+    return (offset + StoreAlignment - 1) & ~(StoreAlignment - 1);
+}
+
+static inline uint64_t HashNode(uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se)
+{
+    uint64_t h = nw * 0x9E3779B97F4A7C15ull;
+    h = (h ^ ne) * 0xC2B2AE3D27D4EB4Full;
+    h = (h ^ sw) * 0x165667B19E3779F9ull;
+    h = (h ^ se) * 0x9E3779B97F4A7C15ull;
+    return h ^ (h >> 29);
+}
+
+static inline uint64_t HashLeaf(uint64_t bits)
+{
+    uint64_t h = (bits ^ (bits >> 30)) * 0xBF58476D1CE4E5B9ull;
+    h = (h ^ (h >> 27)) * 0x94D049BB133111EBull;
+    return h ^ (h >> 31);
+}
+
+// Table is at most 2/3 full when the pool it indexes is full
+static uint64_t TableSizeFor(std::size_t capacity)
+{
+    uint64_t size = 1024;
+    while (size < capacity + capacity / 2)
+        size <<= 1;
+    return size;
+}
+
+Hashlife::Hashlife(std::size_t memoryLimit)
+    :m_Header(nullptr), m_Nodes(nullptr), m_Leaves(nullptr), m_StepResult(nullptr), m_LastUsed(nullptr),
+     m_NodeCount(0), m_LeafCount(0), m_ParallelCutoff(DefaultParallelCutoff),
+     m_OutOfMemory(false), m_NodesCreated(0), m_ResultHits(0), m_ResultMisses(0),
+     m_MemoryLimit(0), m_Capacity(0), m_LeafCapacity(0), m_Root(0), m_RootLevel(0),
+     m_StepLog2(0), m_Generation(0), m_Epoch(1), m_NodeVersion(0), m_PinCount(0), m_PinWaiting(false)
+{
+    SetMemoryLimit(memoryLimit);
+    Clear();
+}
+
+Hashlife::~Hashlife()
+{
+    SyncStore();
+}
+
+void Hashlife::SetThreadCount(unsigned int threadCount, unsigned int parallelCutoff)
+{
+    m_ParallelCutoff = std::max(parallelCutoff, 5u);
+    if (threadCount > 1)
+        m_Pool.reset(new ThreadPool(threadCount));
+    else
+        m_Pool.reset();
+}
+
+// Nodes (and half as many leaves) that fit in a memory cap. The tables round
+// up to powers of two, so the cost per node depends on where the cap falls,
+// search for the largest pool whose whole layout fits.
+std::size_t Hashlife::CapacityFor(std::size_t memoryLimit)
+{
+    std::size_t low = MinCapacity;
+    std::size_t high = LeafBit - 16;
+    if (ComputeLayout(low, low / 2).total > memoryLimit)
+        return low;
+    while (low < high)
+    {
+        std::size_t middle = low + (high - low + 1) / 2;
+        if (ComputeLayout(middle, middle / 2).total <= memoryLimit)
+            low = middle;
+        else
+            high = middle - 1;
+    }
+    return low;
+}
+
+void Hashlife::SetMemoryLimit(std::size_t memoryLimit)
+{
+    std::size_t capacity = CapacityFor(memoryLimit);
+    m_MemoryLimit = memoryLimit;
+
+    uint32_t count = m_NodeCount.load();
+    uint32_t leafCount = m_LeafCount.load();
+    if (count > capacity * 3 / 4 || leafCount > capacity / 2 * 3 / 4)
+    {
+        m_Capacity = capacity;
+        m_LeafCapacity = capacity / 2;
+        CollectGarbage();
+        count = m_NodeCount.load();
+        leafCount = m_LeafCount.load();
+        if (count > capacity || leafCount > capacity / 2)
+        {
+            std::cerr << "Hashlife: live pattern needs more than " << memoryLimit << " bytes" << std::endl;
+            capacity = std::max<std::size_t>(capacity, std::max<std::size_t>(count, leafCount * 2));
+        }
+    }
+
+    AllocatePools(capacity, capacity / 2);
+}
+
+Hashlife::StoreLayout Hashlife::ComputeLayout(std::size_t capacity, std::size_t leafCapacity)
+{
+    StoreLayout layout;
+    layout.capacity = capacity;
+    layout.leafCapacity = leafCapacity;
+    layout.nodeTableSize = TableSizeFor(capacity);
+    layout.leafTableSize = TableSizeFor(leafCapacity);
+    layout.nodes = AlignUp(sizeof(StoreHeader));
+    layout.stepResult = AlignUp(layout.nodes + capacity * sizeof(Node));
+    layout.lastUsed = AlignUp(layout.stepResult + capacity * sizeof(uint32_t));
+    layout.leaves = AlignUp(layout.lastUsed + capacity * sizeof(uint32_t));
+    layout.nodeTable = AlignUp(layout.leaves + leafCapacity * sizeof(uint64_t));
+    layout.leafTable = AlignUp(layout.nodeTable + layout.nodeTableSize * sizeof(uint64_t));
+    layout.total = AlignUp(layout.leafTable + layout.leafTableSize * sizeof(uint64_t));
+    return layout;
+}
+
+void Hashlife::MapPools(const StoreLayout& layout)
+{
+    char* base = (char*)m_Storage.GetData();
+    m_Header = (StoreHeader*)base;
+    m_Nodes = (Node*)(base + layout.nodes);
+    m_StepResult = (std::atomic<uint32_t>*)(base + layout.stepResult);
+    m_LastUsed = (std::atomic<uint32_t>*)(base + layout.lastUsed);
+    m_Leaves = (uint64_t*)(base + layout.leaves);
+    m_NodeTable.slots = (std::atomic<uint64_t>*)(base + layout.nodeTable);
+    m_NodeTable.mask = layout.nodeTableSize - 1;
+    m_LeafTable.slots = (std::atomic<uint64_t>*)(base + layout.leafTable);
+    m_LeafTable.mask = layout.leafTableSize - 1;
+    m_Capacity = layout.capacity;
+    m_LeafCapacity = layout.leafCapacity;
+}
+
+/**
+ * The pools are fixed blocks so threads can allocate from them without
+ * locking, they only move here, never during a step. Untouched pages aren't
+ * committed so a big cap costs nothing up front. With a store file the new
+ * layout is written next to it and renamed over it once complete.
+ */
+bool Hashlife::AllocatePools(std::size_t capacity, std::size_t leafCapacity)
+{
+    WaitForUnpin();
+    StoreLayout layout = ComputeLayout(capacity, leafCapacity);
+    std::string tempPath = m_StorePath + ".tmp";
+    MappedFile storage;
+    bool mapped = m_StorePath.empty() ? storage.CreateAnonymous(layout.total)
+                                      : storage.Create(tempPath, layout.total);
+    if (!mapped)
+        return false;
+
+    uint32_t count = m_NodeCount.load();
+    uint32_t leafCount = m_LeafCount.load();
+    const Node* oldNodes = m_Nodes;
+    const std::atomic<uint32_t>* oldLastUsed = m_LastUsed;
+    const uint64_t* oldLeaves = m_Leaves;
+
+    // Fresh pages are zero, which is what an empty slot or memo looks like
+    char* base = (char*)storage.GetData();
+    Node* nodes = (Node*)(base + layout.nodes);
+    std::atomic<uint32_t>* lastUsed = (std::atomic<uint32_t>*)(base + layout.lastUsed);
+    uint64_t* leaves = (uint64_t*)(base + layout.leaves);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const Node& from = oldNodes[i];
+        Node& to = nodes[i];
+        to.nw = from.nw;
+        to.ne = from.ne;
+        to.sw = from.sw;
+        to.se = from.se;
+        to.result.store(from.result.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        lastUsed[i].store(oldLastUsed[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    if (leafCount)
+        std::memcpy(leaves, oldLeaves, leafCount * sizeof(uint64_t));
+
+    m_Storage.Swap(storage);
+    storage.Close();
+    MapPools(layout);
+    RebuildTables();
+
+    if (!m_StorePath.empty() && std::rename(tempPath.c_str(), m_StorePath.c_str()) != 0)
+        std::cerr << "Hashlife: failed to replace node store " << m_StorePath << std::endl;
+    WriteHeader(true);
+    return true;
+}
+
+void Hashlife::FillHeader(StoreHeader& header, std::size_t capacity, std::size_t leafCapacity, bool clean) const
+{
+    std::memcpy(header.magic, StoreMagic, sizeof(StoreMagic));
+    header.version = StoreVersion;
+    header.nodeSize = sizeof(Node);
+    header.birthMask = BirthMask;
+    header.surviveMask = SurviveMask;
+    header.capacity = capacity;
+    header.leafCapacity = leafCapacity;
+    header.nodeCount = m_NodeCount.load();
+    header.leafCount = m_LeafCount.load();
+    header.generation = m_Generation;
+    header.root = m_Root;
+    header.rootLevel = m_RootLevel;
+    header.stepLog2 = m_StepLog2;
+    header.epoch = m_Epoch;
+    header.clean = clean;
+}
+
+void Hashlife::WriteHeader(bool clean)
+{
+    if (!m_Header)
+        return;
+    FillHeader(*m_Header, m_Capacity, m_LeafCapacity, clean);
+}
+
+// Checks a mapped store or snapshot image was written by a compatible build
+bool Hashlife::IsValidStore(const MappedFile& file)
+{
+    const StoreHeader* header = (const StoreHeader*)file.GetData();
+    return file.GetSize() >= sizeof(StoreHeader)
+        && std::memcmp(header->magic, StoreMagic, sizeof(StoreMagic)) == 0
+        && header->version == StoreVersion
+        && header->nodeSize == sizeof(Node)
+        && header->birthMask == BirthMask
+        && header->surviveMask == SurviveMask
+        && header->capacity < LeafBit
+        && header->nodeCount <= header->capacity
+        && header->leafCount <= header->leafCapacity
+        && ComputeLayout(header->capacity, header->leafCapacity).total == file.GetSize();
+}
+
+// Takes over pools that were just mapped into m_Storage
+void Hashlife::AdoptStorage()
+{
+    const StoreHeader* header = (const StoreHeader*)m_Storage.GetData();
+    MapPools(ComputeLayout(header->capacity, header->leafCapacity));
+    bool clean = m_Header->clean;
+    m_NodeVersion++;
+
+    m_NodeCount = (uint32_t)m_Header->nodeCount;
+    m_LeafCount = (uint32_t)m_Header->leafCount;
+    m_Generation = m_Header->generation;
+    m_Root = m_Header->root;
+    m_RootLevel = m_Header->rootLevel;
+    m_StepLog2 = m_Header->stepLog2;
+    m_Epoch = m_Header->epoch;
+
+    // A run that died mid-step may have left table entries past the
+    // recorded counts, those get dropped. Finished results are kept.
+    if (!clean)
+    {
+        RebuildTables();
+        for (uint32_t i = 0; i < m_NodeCount.load(); i++)
+            m_StepResult[i].store(0, std::memory_order_relaxed);
+    }
+
+    // The canonical empty nodes are already in the tables, this just finds them
+    m_Empty.assign(LeafLevel + 1, 0);
+    m_Empty[LeafLevel] = FindLeaf(0);
+    for (unsigned int level = LeafLevel + 1; level <= MaxLevel; level++)
+    {
+        uint32_t e = m_Empty.back();
+        m_Empty.push_back(Join(e, e, e, e));
+    }
+    WriteHeader(true);
+}
+
+bool Hashlife::OpenStore(const std::string& path)
+{
+    WaitForUnpin();
+    MappedFile file;
+    if (file.Open(path, true))
+    {
+        if (IsValidStore(file))
+        {
+            m_Storage.Swap(file);
+            m_StorePath = path;
+            AdoptStorage();
+
+            std::cout << "Opened node store " << path << ": " << m_NodeCount.load() + m_LeafCount.load()
+                      << " nodes at generation " << m_Generation << std::endl;
+
+            // Honour the memory cap this run was started with
+            if (CapacityFor(m_MemoryLimit) != m_Capacity)
+                SetMemoryLimit(m_MemoryLimit);
+            return true;
+        }
+        std::cerr << "Node store " << path << " is from an incompatible build, starting a new one" << std::endl;
+        file.Close();
+    }
+
+    // Nothing usable on disk, move the current pools into a new file
+    m_StorePath = path;
+    if (!AllocatePools(m_Capacity, m_LeafCapacity))
+    {
+        m_StorePath.clear();
+        return false;
+    }
+    return true;
+}
+
+// Between public calls the store is always consistent, this just flushes it
+void Hashlife::SyncStore()
+{
+    if (m_StorePath.empty())
+        return;
+    if (!m_Storage.Sync())
+        std::cerr << "Hashlife: failed to sync node store " << m_StorePath << std::endl;
+}
+
+void Hashlife::Clear()
+{
+    WaitForUnpin();
+    WriteHeader(false);
+    m_NodeVersion++;
+    m_NodeCount = 1;     // 0 is "no node" in both pools
+    m_LeafCount = 1;
+    RebuildTables();
+
+    // Empty nodes are built up front so the list of them is read-only during steps
+    m_Empty.assign(LeafLevel + 1, 0);
+    m_Empty[LeafLevel] = FindLeaf(0);
+    for (unsigned int level = LeafLevel + 1; level <= MaxLevel; level++)
+    {
+        uint32_t e = m_Empty.back();
+        m_Empty.push_back(Join(e, e, e, e));
+    }
+
+    m_RootLevel = LeafLevel + 1;
+    m_Root = Empty(m_RootLevel);
+    m_Generation = 0;
+    WriteHeader(true);
+}
+
+void Hashlife::BeginLoad()
+{
+    Clear();
+    // Nodes go into the tables ahead of the header counts until EndLoad
+    WriteHeader(false);
+}
+
+bool Hashlife::EndLoad(uint32_t root, unsigned int level, uint64_t generation)
+{
+    // The root of a tiny pattern can be a single leaf
+    if (root && level == LeafLevel)
+    {
+        uint32_t e = Empty(LeafLevel);
+        root = Join(root, e, e, e);
+        level++;
+    }
+    if (!root || level < LeafLevel || level > 62)
+    {
+        Clear();
+        return false;
+    }
+
+    // Centred on the origin like every root
+    m_Root = root;
+    m_RootLevel = level;
+    m_Generation = generation;
+    ShrinkRoot();
+    WriteHeader(true);
+    return true;
+}
+
+void Hashlife::GetChildren(uint32_t node, uint32_t children[4]) const
+{
+    const Node& n = m_Nodes[node];
+    children[0] = n.nw;
+    children[1] = n.ne;
+    children[2] = n.sw;
+    children[3] = n.se;
+}
+
+// Room for half as many nodes again, so a run doesn't have to grow the pools straight away
+Hashlife::StoreLayout Hashlife::ImageLayout() const
+{
+    std::size_t count = m_NodeCount.load();
+    std::size_t leafCount = m_LeafCount.load();
+    return ComputeLayout(std::max(count + count / 2, MinCapacity), std::max(leafCount + leafCount / 2, MinCapacity / 2));
+}
+
+std::size_t Hashlife::PrepareImage()
+{
+    CollectGarbage();
+    return ImageLayout().total;
+}
+
+/**
+ * Same layout as the node store, tables included, so loading is just a
+ * mapping. The header is marked clean and keeps the step size the slow memo
+ * was filled for.
+ */
+void Hashlife::WriteImage(void* dest) const
+{
+    StoreLayout layout = ImageLayout();
+    char* base = (char*)dest;
+    Node* nodes = (Node*)(base + layout.nodes);
+    std::atomic<uint32_t>* stepResult = (std::atomic<uint32_t>*)(base + layout.stepResult);
+    std::atomic<uint32_t>* lastUsed = (std::atomic<uint32_t>*)(base + layout.lastUsed);
+    uint64_t* leaves = (uint64_t*)(base + layout.leaves);
+
+    uint32_t count = m_NodeCount.load();
+    uint32_t leafCount = m_LeafCount.load();
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const Node& from = m_Nodes[i];
+        Node& to = nodes[i];
+        to.nw = from.nw;
+        to.ne = from.ne;
+        to.sw = from.sw;
+        to.se = from.se;
+        to.result.store(from.result.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        stepResult[i].store(m_StepResult[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        lastUsed[i].store(m_LastUsed[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    std::memcpy(leaves, m_Leaves, leafCount * sizeof(uint64_t));
+
+    HashTable nodeTable, leafTable;
+    nodeTable.slots = (std::atomic<uint64_t>*)(base + layout.nodeTable);
+    nodeTable.mask = layout.nodeTableSize - 1;
+    leafTable.slots = (std::atomic<uint64_t>*)(base + layout.leafTable);
+    leafTable.mask = layout.leafTableSize - 1;
+    FillTables(nodes, count, leaves, leafCount, nodeTable, leafTable);
+
+    FillHeader(*(StoreHeader*)base, layout.capacity, layout.leafCapacity, true);
+}
+
+bool Hashlife::MapImage(MappedFile& image)
+{
+    WaitForUnpin();
+    if (!IsValidStore(image))
+    {
+        std::cerr << "Hashlife: snapshot image is from an incompatible build" << std::endl;
+        return false;
+    }
+
+    m_Storage.Swap(image);
+    image.Close();
+    AdoptStorage();
+
+    // With a node store the image is copied into it, otherwise only a cap
+    // smaller than the snapshot forces a copy
+    if (!m_StorePath.empty())
+        return AllocatePools(m_Capacity, m_LeafCapacity);
+    if (CapacityFor(m_MemoryLimit) < m_Capacity)
+        SetMemoryLimit(m_MemoryLimit);
+    return true;
+}
+
+/**
+ * Lock-free hash-consing. A new node is written before the compare-exchange
+ * that publishes its slot, so whoever finds it there sees it complete. If
+ * another thread wins the slot with the same node, ours is simply left
+ * unreferenced for the next collection to sweep up.
+ */
+uint32_t Hashlife::Join(uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se)
+{
+    if (!nw || !ne || !sw || !se)
+        return 0;
+
+    uint64_t hash = HashNode(nw, ne, sw, se);
+    uint64_t tag = hash & TagMask;
+    uint32_t created = 0;
+    for (uint64_t i = hash & m_NodeTable.mask; ; i = (i + 1) & m_NodeTable.mask)
+    {
+        uint64_t slot = m_NodeTable.slots[i].load(std::memory_order_acquire);
+        if (slot == 0)
+        {
+            if (!created)
+            {
+                // Pool is full, the caller unwinds and the step gets retried after a collection
+                created = m_NodeCount.fetch_add(1, std::memory_order_relaxed);
+                if (created >= m_Capacity)
+                {
+                    m_NodeCount.fetch_sub(1, std::memory_order_relaxed);
+                    m_OutOfMemory.store(true, std::memory_order_relaxed);
+                    return 0;
+                }
+                Node& node = m_Nodes[created];
+                node.nw = nw;
+                node.ne = ne;
+                node.sw = sw;
+                node.se = se;
+                node.result.store(0, std::memory_order_relaxed);
+                m_StepResult[created].store(0, std::memory_order_relaxed);
+                m_LastUsed[created].store(m_Epoch, std::memory_order_relaxed);
+            }
+            if (m_NodeTable.slots[i].compare_exchange_strong(slot, tag | created,
+                    std::memory_order_release, std::memory_order_acquire))
+            {
+                s_Counters.nodesCreated++;
+                return created;
+            }
+        }
+        if ((slot & TagMask) == tag)
+        {
+            uint32_t index = (uint32_t)slot;
+            const Node& node = m_Nodes[index];
+            if (node.nw == nw && node.ne == ne && node.sw == sw && node.se == se)
+                return index;
+        }
+    }
+}
+
+uint32_t Hashlife::FindLeaf(uint64_t bits)
+{
+    uint64_t hash = HashLeaf(bits);
+    uint64_t tag = hash & TagMask;
+    uint32_t created = 0;
+    for (uint64_t i = hash & m_LeafTable.mask; ; i = (i + 1) & m_LeafTable.mask)
+    {
+        uint64_t slot = m_LeafTable.slots[i].load(std::memory_order_acquire);
+        if (slot == 0)
+        {
+            if (!created)
+            {
+                created = m_LeafCount.fetch_add(1, std::memory_order_relaxed);
+                if (created >= m_LeafCapacity)
+                {
+                    m_LeafCount.fetch_sub(1, std::memory_order_relaxed);
+                    m_OutOfMemory.store(true, std::memory_order_relaxed);
+                    return 0;
+                }
+                m_Leaves[created] = bits;
+            }
+            if (m_LeafTable.slots[i].compare_exchange_strong(slot, tag | created,
+                    std::memory_order_release, std::memory_order_acquire))
+            {
+                s_Counters.nodesCreated++;
+                return created | LeafBit;
+            }
+        }
+        if ((slot & TagMask) == tag && m_Leaves[(uint32_t)slot] == bits)
+            return (uint32_t)slot | LeafBit;
+    }
+}
+
+/**
+ * Nodes are never changed once they are in the table and steps only append,
+ * so a pinned tree stays intact while stepping goes on. Only the calls that
+ * compact, move or reset the pools have to wait.
+ */
+Hashlife::PinnedRoot Hashlife::Pin()
+{
+    std::lock_guard<std::mutex> lock(m_PinMutex);
+    m_PinCount++;
+    return { m_Root, m_RootLevel, m_Generation };
+}
+
+void Hashlife::Unpin()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_PinMutex);
+        m_PinCount--;
+    }
+    m_Unpinned.notify_all();
+}
+
+void Hashlife::WaitForUnpin()
+{
+    std::unique_lock<std::mutex> lock(m_PinMutex);
+    if (!m_PinCount)
+        return;
+
+    auto start = std::chrono::steady_clock::now();
+    m_PinWaiting = true;
+    m_Unpinned.wait(lock, [this] { return m_PinCount == 0; });
+    m_PinWaiting = false;
+    m_Stats.pinWaitMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+unsigned int Hashlife::GetThreadCount() const
+{
+    return m_Pool ? m_Pool->GetThreadCount() : 1;
+}
+
+bool Hashlife::IsParallel(unsigned int level) const
+{
+    return m_Pool && level >= m_ParallelCutoff;
+}
+
+void Hashlife::FlushCounters()
+{
+    m_NodesCreated.fetch_add(s_Counters.nodesCreated, std::memory_order_relaxed);
+    m_ResultHits.fetch_add(s_Counters.resultHits, std::memory_order_relaxed);
+    m_ResultMisses.fetch_add(s_Counters.resultMisses, std::memory_order_relaxed);
+    s_Counters = {};
+}
+
+uint32_t Hashlife::Centre(uint32_t node, unsigned int level)
+{
+    const Node& n = m_Nodes[node];
+    if (level == LeafLevel + 1)
+        return FindLeaf(CentreLeaf(LeafBits(n.nw), LeafBits(n.ne), LeafBits(n.sw), LeafBits(n.se)));
+
+    uint32_t nw = m_Nodes[n.nw].se;
+    uint32_t ne = m_Nodes[n.ne].sw;
+    uint32_t sw = m_Nodes[n.sw].ne;
+    uint32_t se = m_Nodes[n.se].nw;
+    return Join(nw, ne, sw, se);
+}
+
+/**
+ * Splits a node (level 5 or more) into the 3x3 grid of overlapping
+ * half-size nodes:
+ *   0 1 2
+ *   3 4 5
+ *   6 7 8
+ */
+bool Hashlife::NinePieces(uint32_t node, uint32_t pieces[9])
+{
+    const Node& n = m_Nodes[node];
+    const Node& nw = m_Nodes[n.nw];
+    const Node& ne = m_Nodes[n.ne];
+    const Node& sw = m_Nodes[n.sw];
+    const Node& se = m_Nodes[n.se];
+
+    pieces[0] = n.nw;
+    pieces[1] = Join(nw.ne, ne.nw, nw.se, ne.sw);
+    pieces[2] = n.ne;
+    pieces[3] = Join(nw.sw, nw.se, sw.nw, sw.ne);
+    pieces[4] = Join(nw.se, ne.sw, sw.ne, se.nw);
+    pieces[5] = Join(ne.sw, ne.se, se.nw, se.ne);
+    pieces[6] = n.sw;
+    pieces[7] = Join(sw.ne, se.nw, sw.se, se.sw);
+    pieces[8] = n.se;
+
+    for (int i = 0; i < 9; i++)
+        if (!pieces[i])
+            return false;
+    return true;
+}
+
+/**
+ * Second half of the Hashlife recursion: joins the nine quarter-size parts
+ * into four overlapping nodes, advances each and joins the results.
+ */
+uint32_t Hashlife::CombineAndAdvance(const uint32_t parts[9], unsigned int level)
+{
+    uint32_t quads[4] = {
+        Join(parts[0], parts[1], parts[3], parts[4]),
+        Join(parts[1], parts[2], parts[4], parts[5]),
+        Join(parts[3], parts[4], parts[6], parts[7]),
+        Join(parts[4], parts[5], parts[7], parts[8])
+    };
+
+    if (IsParallel(level))
+    {
+        m_Pool->Run(4, [&](unsigned int i) {
+            quads[i] = Advance(quads[i], level - 1);
+            FlushCounters();
+        });
+    }
+    else
+    {
+        for (int i = 0; i < 4; i++)
+            quads[i] = Advance(quads[i], level - 1);
+    }
+    return Join(quads[0], quads[1], quads[2], quads[3]);
+}
+
+// Centre half of the node advanced by 2^min(level - 2, stepLog2) generations
+uint32_t Hashlife::Advance(uint32_t node, unsigned int level)
+{
+    if (!node || m_OutOfMemory.load(std::memory_order_relaxed))
+        return 0;
+    if (m_StepLog2 + 2 >= level)
+        return FullResult(node, level);
+    return SlowResult(node, level);
+}
+
+uint32_t Hashlife::FullResult(uint32_t node, unsigned int level)
+{
+    m_LastUsed[node].store(m_Epoch, std::memory_order_relaxed);
+    uint32_t result = m_Nodes[node].result.load(std::memory_order_acquire);
+    if (result)
+    {
+        s_Counters.resultHits++;
+        return result;
+    }
+    s_Counters.resultMisses++;
+
+    // Two threads may race to fill the same result, hash-consing makes
+    // both answers the same node so the second store is harmless.
+    if (node == Empty(level))
+        result = Empty(level - 1);
+    else if (level == LeafLevel + 1)
+        result = LeafResult(node, 4);
+    else
+    {
+        uint32_t pieces[9];
+        if (!NinePieces(node, pieces))
+            return 0;
+        uint32_t parts[9];
+        if (IsParallel(level))
+        {
+            m_Pool->Run(9, [&](unsigned int i) {
+                parts[i] = Advance(pieces[i], level - 1);
+                FlushCounters();
+            });
+        }
+        else
+        {
+            for (int i = 0; i < 9; i++)
+                parts[i] = FullResult(pieces[i], level - 1);
+        }
+        result = CombineAndAdvance(parts, level);
+    }
+
+    if (result)
+        m_Nodes[node].result.store(result, std::memory_order_release);
+    return result;
+}
+
+// Same as FullResult but the first half of the recursion doesn't move time
+uint32_t Hashlife::SlowResult(uint32_t node, unsigned int level)
+{
+    m_LastUsed[node].store(m_Epoch, std::memory_order_relaxed);
+    uint32_t result = m_StepResult[node].load(std::memory_order_acquire);
+    if (result)
+    {
+        s_Counters.resultHits++;
+        return result;
+    }
+    s_Counters.resultMisses++;
+
+    if (node == Empty(level))
+        result = Empty(level - 1);
+    else if (level == LeafLevel + 1)
+        result = LeafResult(node, 1u << m_StepLog2);
+    else
+    {
+        uint32_t pieces[9];
+        if (!NinePieces(node, pieces))
+            return 0;
+        uint32_t parts[9];
+        for (int i = 0; i < 9; i++)
+            parts[i] = Centre(pieces[i], level - 1);
+        result = CombineAndAdvance(parts, level);
+    }
+
+    if (result)
+        m_StepResult[node].store(result, std::memory_order_release);
+    return result;
+}
+
+// A level 4 node is a 16x16 block of four leaves, the kernel steps it directly
+uint32_t Hashlife::LeafResult(uint32_t node, unsigned int generations)
+{
+    const Node& n = m_Nodes[node];
+    return FindLeaf(StepLeafBlock(LeafBits(n.nw), LeafBits(n.ne), LeafBits(n.sw), LeafBits(n.se),
+                                  generations, BirthMask, SurviveMask));
+}
+
+bool Hashlife::ExpandRoot()
+{
+    // Coordinates are int64 so the universe can't grow past 2^62 cells wide
+    if (m_RootLevel >= 62)
+        return false;
+
+    uint32_t e = Empty(m_RootLevel - 1);
+    const Node& root = m_Nodes[m_Root];
+    uint32_t nw = Join(e, e, e, root.nw);
+    uint32_t ne = Join(e, e, root.ne, e);
+    uint32_t sw = Join(e, root.sw, e, e);
+    uint32_t se = Join(root.se, e, e, e);
+    uint32_t expanded = Join(nw, ne, sw, se);
+    if (!expanded)
+        return false;
+
+    m_Root = expanded;
+    m_RootLevel++;
+    return true;
+}
+
+void Hashlife::ShrinkRoot()
+{
+    while (m_RootLevel > LeafLevel + 1 && !RootHasBorder())
+    {
+        uint32_t centre = Centre(m_Root, m_RootLevel);
+        if (!centre)
+            return;
+        m_Root = centre;
+        m_RootLevel--;
+    }
+}
+
+// True when some live cell lies outside the centre half of the root
+bool Hashlife::RootHasBorder() const
+{
+    const Node& root = m_Nodes[m_Root];
+    if (m_RootLevel == LeafLevel + 1)
+    {
+        return (LeafBits(root.nw) & ~LeafSE) || (LeafBits(root.ne) & ~LeafSW)
+            || (LeafBits(root.sw) & ~LeafNE) || (LeafBits(root.se) & ~LeafNW);
+    }
+
+    uint32_t e = Empty(m_RootLevel - 2);
+    const Node& nw = m_Nodes[root.nw];
+    const Node& ne = m_Nodes[root.ne];
+    const Node& sw = m_Nodes[root.sw];
+    const Node& se = m_Nodes[root.se];
+    return nw.nw != e || nw.ne != e || nw.sw != e
+        || ne.nw != e || ne.ne != e || ne.se != e
+        || sw.nw != e || sw.sw != e || sw.se != e
+        || se.ne != e || se.sw != e || se.se != e;
+}
+
+void Hashlife::SetStepLog2(unsigned int stepLog2)
+{
+    if (stepLog2 == m_StepLog2)
+        return;
+    // Full speed results don't depend on the step, only the slow memo does
+    m_StepLog2 = stepLog2;
+    const char* base = (const char*)m_Storage.GetData();
+    m_Storage.Zero((const char*)m_StepResult - base, m_NodeCount.load() * sizeof(uint32_t));
+}
+
+bool Hashlife::StepOnce(unsigned int stepLog2)
+{
+    SetStepLog2(stepLog2);
+    m_OutOfMemory = false;
+
+    // Pattern has to sit in the centre half with room to grow by 2^stepLog2,
+    // then one more ring of padding because the result is the centre half.
+    while (m_RootLevel < stepLog2 + 2 || RootHasBorder())
+        if (!ExpandRoot())
+            return false;
+    if (!ExpandRoot())
+        return false;
+
+    uint32_t result = Advance(m_Root, m_RootLevel);
+    FlushCounters();
+    if (!result || m_OutOfMemory)
+        return false;
+
+    m_Root = result;
+    m_RootLevel--;
+    m_Generation += (uint64_t)1 << stepLog2;
+    ShrinkRoot();
+    return true;
+}
+
+bool Hashlife::Step(unsigned int stepLog2)
+{
+    if (stepLog2 > MaxStepLog2)
+    {
+        std::cerr << "Hashlife: step 2^" << stepLog2 << " is too large" << std::endl;
+        return false;
+    }
+
+    // A store left marked dirty by a crash mid-step gets its tables rebuilt
+    WriteHeader(false);
+    bool stepped = StepWithRetry(stepLog2);
+    WriteHeader(true);
+    return stepped;
+}
+
+bool Hashlife::StepWithRetry(unsigned int stepLog2)
+{
+    m_Epoch++;
+    MaybeCollect();
+    if (StepOnce(stepLog2))
+        return true;
+    m_Stats.retries++;
+
+    // Nodes are immutable so the root from before the step is still intact,
+    // take any room left under the cap or else throw away every memoized
+    // result, and try again.
+    if (GrowPools() && StepOnce(stepLog2))
+        return true;
+    CollectGarbage(false);
+    if (StepOnce(stepLog2))
+        return true;
+
+    if (stepLog2 == 0)
+    {
+        std::cerr << "Hashlife: pattern doesn't fit in " << m_MemoryLimit << " bytes" << std::endl;
+        return false;
+    }
+    // Smaller steps need a smaller working set
+    return StepWithRetry(stepLog2 - 1) && StepWithRetry(stepLog2 - 1);
+}
+
+uint32_t Hashlife::SetCellRecursive(uint32_t node, unsigned int level, uint64_t x, uint64_t y, bool alive)
+{
+    if (level == LeafLevel)
+    {
+        uint64_t bit = (uint64_t)1 << (y * 8 + x);
+        uint64_t bits = LeafBits(node);
+        return FindLeaf(alive ? bits | bit : bits & ~bit);
+    }
+
+    const Node& n = m_Nodes[node];
+    uint32_t nw = n.nw, ne = n.ne, sw = n.sw, se = n.se;
+    uint64_t half = (uint64_t)1 << (level - 1);
+    if (y < half)
+    {
+        if (x < half)
+            nw = SetCellRecursive(nw, level - 1, x, y, alive);
+        else
+            ne = SetCellRecursive(ne, level - 1, x - half, y, alive);
+    }
+    else
+    {
+        if (x < half)
+            sw = SetCellRecursive(sw, level - 1, x, y - half, alive);
+        else
+            se = SetCellRecursive(se, level - 1, x - half, y - half, alive);
+    }
+    return Join(nw, ne, sw, se);
+}
+
+void Hashlife::SetCell(int64_t x, int64_t y, bool alive)
+{
+    WriteHeader(false);
+    for (int attempt = 0; attempt < 2; attempt++)
+    {
+        m_OutOfMemory = false;
+        bool fits = true;
+        for (;;)
+        {
+            int64_t half = (int64_t)1 << (m_RootLevel - 1);
+            if (x >= -half && x < half && y >= -half && y < half)
+                break;
+            if (!ExpandRoot())
+            {
+                fits = false;
+                break;
+            }
+        }
+
+        if (fits)
+        {
+            int64_t half = (int64_t)1 << (m_RootLevel - 1);
+            uint32_t root = SetCellRecursive(m_Root, m_RootLevel, (uint64_t)(x + half), (uint64_t)(y + half), alive);
+            if (root)
+            {
+                m_Root = root;
+                WriteHeader(true);
+                return;
+            }
+        }
+        CollectGarbage(false);
+    }
+    std::cerr << "Hashlife: no room to set cell " << x << ", " << y << std::endl;
+    WriteHeader(true);
+}
+
+bool Hashlife::GetCell(int64_t x, int64_t y) const
+{
+    int64_t half = (int64_t)1 << (m_RootLevel - 1);
+    if (x < -half || x >= half || y < -half || y >= half)
+        return false;
+
+    uint64_t ux = (uint64_t)(x + half);
+    uint64_t uy = (uint64_t)(y + half);
+    uint32_t node = m_Root;
+    for (unsigned int level = m_RootLevel; level > LeafLevel; level--)
+    {
+        if (node == Empty(level))
+            return false;
+        const Node& n = m_Nodes[node];
+        uint64_t size = (uint64_t)1 << (level - 1);
+        bool east = ux & size;
+        bool south = uy & size;
+        node = south ? (east ? n.se : n.sw) : (east ? n.ne : n.nw);
+    }
+    return (LeafBits(node) >> ((uy & 7) * 8 + (ux & 7))) & 1;
+}
+
+uint64_t Hashlife::CountPopulation(uint32_t node, unsigned int level, std::unordered_map<uint32_t, uint64_t>& memo) const
+{
+    if (level == LeafLevel)
+        return (uint64_t)__builtin_popcountll(LeafBits(node));
+    if (node == Empty(level))
+        return 0;
+
+    auto it = memo.find(node);
+    if (it != memo.end())
+        return it->second;
+
+    const Node& n = m_Nodes[node];
+    uint64_t population = CountPopulation(n.nw, level - 1, memo) + CountPopulation(n.ne, level - 1, memo)
+                        + CountPopulation(n.sw, level - 1, memo) + CountPopulation(n.se, level - 1, memo);
+    memo.emplace(node, population);
+    return population;
+}
+
+// Nodes don't carry a population, so this walks every distinct node once
+uint64_t Hashlife::GetPopulation() const
+{
+    std::unordered_map<uint32_t, uint64_t> memo;
+    return CountPopulation(m_Root, m_RootLevel, memo);
+}
+
+void Hashlife::Mark(uint32_t node, unsigned int level, MarkState& state) const
+{
+    std::vector<std::pair<uint32_t, unsigned int>> stack;
+    stack.push_back({ node, level });
+    while (!stack.empty())
+    {
+        uint32_t index = stack.back().first;
+        unsigned int nodeLevel = stack.back().second;
+        stack.pop_back();
+
+        if (nodeLevel == LeafLevel)
+        {
+            if (!state.leafMarked[index & ~LeafBit])
+            {
+                state.leafMarked[index & ~LeafBit] = 1;
+                state.liveCount++;
+            }
+            continue;
+        }
+        if (state.nodeLevel[index])
+            continue;
+        state.nodeLevel[index] = (uint8_t)nodeLevel;
+        state.liveCount++;
+
+        const Node& n = m_Nodes[index];
+        if (n.result.load(std::memory_order_relaxed))
+            state.withResults.push_back({ index, (uint8_t)nodeLevel });
+        stack.push_back({ n.nw, nodeLevel - 1 });
+        stack.push_back({ n.ne, nodeLevel - 1 });
+        stack.push_back({ n.sw, nodeLevel - 1 });
+        stack.push_back({ n.se, nodeLevel - 1 });
+    }
+}
+
+/**
+ * Mark-and-sweep. Everything reachable from the root and the canonical empty
+ * nodes survives. Memoized results are then kept most-recently-used first
+ * until the pools are half full, the rest are dropped.
+ */
+void Hashlife::CollectGarbage(bool keepResults)
+{
+    WaitForUnpin();
+    auto start = std::chrono::steady_clock::now();
+    WriteHeader(false);
+
+    MarkState state;
+    state.nodeLevel.assign(m_NodeCount.load(), 0);
+    state.leafMarked.assign(m_LeafCount.load(), 0);
+
+    Mark(m_Root, m_RootLevel, state);
+    for (unsigned int level = LeafLevel; level < m_Empty.size(); level++)
+        Mark(m_Empty[level], level, state);
+
+    if (keepResults)
+    {
+        std::priority_queue<std::tuple<uint32_t, uint32_t, uint8_t>> recent;
+        for (const auto& entry : state.withResults)
+            recent.push(std::make_tuple(m_LastUsed[entry.first].load(std::memory_order_relaxed), entry.first, entry.second));
+
+        uint64_t target = (m_Capacity + m_LeafCapacity) / 2;
+        while (!recent.empty() && state.liveCount < target)
+        {
+            uint32_t index = std::get<1>(recent.top());
+            unsigned int level = std::get<2>(recent.top());
+            recent.pop();
+
+            state.withResults.clear();
+            Mark(m_Nodes[index].result.load(std::memory_order_relaxed), level - 1, state);
+            for (const auto& entry : state.withResults)
+                recent.push(std::make_tuple(m_LastUsed[entry.first].load(std::memory_order_relaxed), entry.first, entry.second));
+        }
+    }
+
+    Compact(state);
+    m_NodeVersion++;
+    WriteHeader(true);
+
+    auto end = std::chrono::steady_clock::now();
+    double pauseMs = std::chrono::duration<double, std::milli>(end - start).count();
+    m_Stats.gcCount++;
+    m_Stats.lastGcPauseMs = pauseMs;
+    m_Stats.maxGcPauseMs = std::max(m_Stats.maxGcPauseMs, pauseMs);
+    m_Stats.totalGcPauseMs += pauseMs;
+}
+
+/**
+ * Slides the surviving nodes and leaves down so the pools stay dense.
+ * Children are always created before their parents, so one forward pass can
+ * remap them in place. The level recorded while marking says which pool a
+ * node's children and result live in.
+ */
+void Hashlife::Compact(const MarkState& state)
+{
+    uint32_t leafCount = m_LeafCount.load();
+    std::vector<uint32_t> leafRemap(leafCount, 0);
+    uint32_t nextLeaf = 1;
+    for (uint32_t i = 1; i < leafCount; i++)
+    {
+        if (!state.leafMarked[i])
+            continue;
+        m_Leaves[nextLeaf] = m_Leaves[i];
+        leafRemap[i] = nextLeaf++ | LeafBit;
+    }
+    m_LeafCount = nextLeaf;
+
+    uint32_t count = m_NodeCount.load();
+    std::vector<uint32_t> remap(count, 0);
+    uint32_t next = 1;
+    for (uint32_t i = 1; i < count; i++)
+    {
+        unsigned int level = state.nodeLevel[i];
+        if (!level)
+            continue;
+
+        bool leaves = level == LeafLevel + 1;
+        auto child = [&](uint32_t index) { return leaves ? leafRemap[index & ~LeafBit] : remap[index]; };
+        Node& from = m_Nodes[i];
+        Node& to = m_Nodes[next];
+        to.nw = child(from.nw);
+        to.ne = child(from.ne);
+        to.sw = child(from.sw);
+        to.se = child(from.se);
+        to.result.store(from.result.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        m_LastUsed[next].store(m_LastUsed[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        m_StepResult[next].store(0, std::memory_order_relaxed);
+        remap[i] = next++;
+    }
+    m_NodeCount = next;
+
+    // Results can point forwards, so they are remapped once everything moved
+    for (uint32_t i = 1; i < count; i++)
+    {
+        unsigned int level = state.nodeLevel[i];
+        if (!level)
+            continue;
+        Node& n = m_Nodes[remap[i]];
+        uint32_t result = n.result.load(std::memory_order_relaxed);
+        result = level == LeafLevel + 1 ? leafRemap[result & ~LeafBit] : remap[result];
+        n.result.store(result, std::memory_order_relaxed);
+    }
+    RebuildTables();
+
+    m_Root = remap[m_Root];
+    m_Empty[LeafLevel] = leafRemap[m_Empty[LeafLevel] & ~LeafBit];
+    for (unsigned int level = LeafLevel + 1; level < m_Empty.size(); level++)
+        m_Empty[level] = remap[m_Empty[level]];
+}
+
+void Hashlife::RebuildTables()
+{
+    // Touching every slot would commit the whole table even when the pools are nearly empty
+    const char* base = (const char*)m_Storage.GetData();
+    m_Storage.Zero((const char*)m_NodeTable.slots - base, (m_NodeTable.mask + 1) * sizeof(uint64_t));
+    m_Storage.Zero((const char*)m_LeafTable.slots - base, (m_LeafTable.mask + 1) * sizeof(uint64_t));
+    FillTables(m_Nodes, m_NodeCount.load(), m_Leaves, m_LeafCount.load(), m_NodeTable, m_LeafTable);
+}
+
+// Tables have to be all zero going in
+void Hashlife::FillTables(const Node* nodes, uint32_t count, const uint64_t* leaves, uint32_t leafCount,
+                          HashTable& nodeTable, HashTable& leafTable)
+{
+    for (uint32_t index = 1; index < count; index++)
+    {
+        const Node& n = nodes[index];
+        uint64_t hash = HashNode(n.nw, n.ne, n.sw, n.se);
+        uint64_t i = hash & nodeTable.mask;
+        while (nodeTable.slots[i].load(std::memory_order_relaxed))
+            i = (i + 1) & nodeTable.mask;
+        nodeTable.slots[i].store((hash & TagMask) | index, std::memory_order_relaxed);
+    }
+
+    for (uint32_t index = 1; index < leafCount; index++)
+    {
+        uint64_t hash = HashLeaf(leaves[index]);
+        uint64_t i = hash & leafTable.mask;
+        while (leafTable.slots[i].load(std::memory_order_relaxed))
+            i = (i + 1) & leafTable.mask;
+        leafTable.slots[i].store((hash & TagMask) | index, std::memory_order_relaxed);
+    }
+}
+
+void Hashlife::MaybeCollect()
+{
+    if (m_NodeCount.load() > m_Capacity * 3 / 4 || m_LeafCount.load() > m_LeafCapacity * 3 / 4)
+    {
+        if (!GrowPools())
+            CollectGarbage();
+    }
+}
+
+// Pools mapped from a snapshot start out smaller than the cap allows
+bool Hashlife::GrowPools()
+{
+    std::size_t capacity = CapacityFor(m_MemoryLimit);
+    if (capacity <= m_Capacity && capacity / 2 <= m_LeafCapacity)
+        return false;
+    return AllocatePools(std::max(capacity, m_Capacity), std::max(capacity / 2, m_LeafCapacity));
+}
+
+const HashlifeStats& Hashlife::GetStats()
+{
+    m_Stats.nodeCount = m_NodeCount.load() + m_LeafCount.load() - 2;
+    m_Stats.nodeCapacity = m_Capacity + m_LeafCapacity;
+    m_Stats.nodesCreated = m_NodesCreated.load();
+    m_Stats.resultHits = m_ResultHits.load();
+    m_Stats.resultMisses = m_ResultMisses.load();
+    return m_Stats;
+}
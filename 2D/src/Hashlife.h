@@ -0,0 +1,250 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "MappedFile.h"
+
+class ThreadPool;
+
+/**
+ * Counters exposed by the Hashlife engine so the caller can see how close it
+ * is to its memory cap and how well the memoization is doing.
+ */
+struct HashlifeStats
+{
+    uint64_t nodeCount = 0;       // nodes and leaves currently alive in the pools
+    uint64_t nodeCapacity = 0;    // nodes and leaves that fit in the memory cap
+    uint64_t nodesCreated = 0;    // total nodes ever created (for rates)
+    uint64_t resultHits = 0;      // memoized results that were reused
+    uint64_t resultMisses = 0;    // memoized results that had to be computed
+    uint64_t gcCount = 0;
+    uint64_t retries = 0;         // steps that ran out of memory and had to be tried again
+    double lastGcPauseMs = 0.0;
+    double maxGcPauseMs = 0.0;
+    double totalGcPauseMs = 0.0;
+    double pinWaitMs = 0.0;       // time spent waiting for a pinned tree to be released
+
+    double HitRate() const
+    {
+        uint64_t lookups = resultHits + resultMisses;
+        return lookups ? (double)resultHits / (double)lookups : 0.0;
+    }
+};
+
+/**
+ * Gosper's Hashlife on a hash-consed quadtree.
+ *
+ * The bottom of the tree is 8x8 leaves (level 3) stored as 64-bit bitmaps in
+ * their own pool, see LifeKernel.h for the bit layout. Everything above is a
+ * 20 byte node of four child indices plus a memoized result. Nodes don't store
+ * their level, it is always known from the level of the root being walked.
+ * Level 4 results come straight from the bit-parallel kernel.
+ *
+ * Leaf references have the top bit set so they never collide with node
+ * indices. Index 0 means "no node" in both pools and is also what node creation
+ * returns when a pool is full, so a step that runs out of memory unwinds,
+ * collects garbage and retries.
+ *
+ * Memory use is capped: when a pool gets close to the cap a mark-and-sweep
+ * collection keeps everything reachable from the live roots and then keeps
+ * memoized results in least-recently-used order until the budget is spent.
+ *
+ * All pools, tables and memo arrays live in one mapped region. By default it
+ * is anonymous memory, OpenStore() puts it in a file instead so a later run
+ * can map it back and keep every memoized result.
+ *
+ * Steps can run on several threads. Levels at or above the parallel cutoff
+ * hand their nine (and then four) subproblems to a thread pool, lower levels
+ * recurse serially. Both pools are fixed arrays with atomic bump allocators
+ * and are hash-consed through lock-free open-addressing tables that keep the
+ * hash inline next to the index, so every thread shares the same tables and
+ * gets the same answer as a serial run. Collections only ever happen between
+ * steps, on the calling thread.
+ */
+class Hashlife
+{
+public:
+    static constexpr std::size_t DefaultMemoryLimit = (std::size_t)1 << 30;
+    static constexpr unsigned int MaxStepLog2 = 48;
+    static constexpr unsigned int LeafLevel = 3;
+
+    static constexpr unsigned int DefaultParallelCutoff = 10;
+
+    Hashlife(std::size_t memoryLimit = DefaultMemoryLimit);
+    ~Hashlife();
+
+    // 1 runs everything on the calling thread
+    void SetThreadCount(unsigned int threadCount, unsigned int parallelCutoff = DefaultParallelCutoff);
+
+    void SetMemoryLimit(std::size_t memoryLimit);
+    std::size_t GetMemoryLimit() const { return m_MemoryLimit; }
+
+    // Maps the node store from `path`, creating it from the current pools if
+    // the file is missing or was written by an incompatible build.
+    bool OpenStore(const std::string& path);
+    void SyncStore();
+
+    void Clear();
+    bool IsEmpty() const { return m_Root == Empty(m_RootLevel); }
+    void SetCell(int64_t x, int64_t y, bool alive);
+    bool GetCell(int64_t x, int64_t y) const;
+
+    // Advances the universe by 2^stepLog2 generations. False if the pattern
+    // doesn't fit in memory. A step that runs out is split into smaller ones,
+    // so a failed step can still have gone part of the way, GetGeneration()
+    // says how far.
+    bool Step(unsigned int stepLog2);
+
+    uint64_t GetGeneration() const { return m_Generation; }
+    uint64_t GetPopulation() const;
+    unsigned int GetRootLevel() const { return m_RootLevel; }
+
+    void CollectGarbage(bool keepResults = true);
+    const HashlifeStats& GetStats();
+
+    // Direct access to the tree for pattern readers and writers. References
+    // are only good until the next Step() or collection. Loaders build bottom
+    // up between BeginLoad() and EndLoad(), which replace the whole universe.
+    void BeginLoad();
+    bool EndLoad(uint32_t root, unsigned int level, uint64_t generation = 0);
+    uint32_t MakeLeaf(uint64_t bits) { return FindLeaf(bits); }
+    uint32_t MakeNode(uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se) { return Join(nw, ne, sw, se); }
+    uint32_t EmptyNode(unsigned int level) const { return Empty(level); }
+    uint32_t GetRoot() const { return m_Root; }
+    // Changes whenever node indices may have been reused (collection, Clear,
+    // a load, a store or image taken over), caches keyed by index go stale then
+    uint64_t GetNodeVersion() const { return m_NodeVersion; }
+    uint64_t GetLeafBits(uint32_t leaf) const { return LeafBits(leaf); }
+    void GetChildren(uint32_t node, uint32_t children[4]) const;
+
+    // Keeps the current tree readable from another thread, e.g. a background
+    // checkpoint. Steps carry on while pinned, but anything that would move or
+    // free nodes (collection, growing the pools, Clear) waits for Unpin().
+    struct PinnedRoot
+    {
+        uint32_t root;
+        unsigned int level;
+        uint64_t generation;
+    };
+    PinnedRoot Pin();
+    void Unpin();
+    bool IsWaitingForUnpin() const { return m_PinWaiting.load(); }
+    unsigned int GetThreadCount() const;
+
+    // Snapshot images are the node store laid out for exactly the live nodes.
+    // PrepareImage() collects garbage and returns the image size, WriteImage()
+    // fills that many (zeroed) bytes. MapImage() runs straight out of a mapped
+    // image, pools only get copied once they need to grow.
+    std::size_t PrepareImage();
+    void WriteImage(void* dest) const;
+    bool MapImage(MappedFile& image);
+
+private:
+    struct Node
+    {
+        uint32_t nw, ne, sw, se;          // leaf indices at level 4, node indices above
+        std::atomic<uint32_t> result;     // memoized 2^(level-2) step, 0 if unknown
+    };
+
+    // Open addressing, each slot is (hash << 32 | index) and 0 when empty
+    struct HashTable
+    {
+        std::atomic<uint64_t>* slots = nullptr;
+        uint64_t mask = 0;
+    };
+
+    struct MarkState;
+    struct StoreHeader;
+    struct StoreLayout;
+
+    MappedFile m_Storage;
+    std::string m_StorePath;
+    StoreHeader* m_Header;
+
+    Node* m_Nodes;
+    uint64_t* m_Leaves;
+    std::atomic<uint32_t>* m_StepResult;  // memo for steps smaller than full speed
+    std::atomic<uint32_t>* m_LastUsed;    // epoch of the last result lookup, for LRU
+    std::atomic<uint32_t> m_NodeCount;
+    std::atomic<uint32_t> m_LeafCount;
+    HashTable m_NodeTable;
+    HashTable m_LeafTable;
+    std::vector<uint32_t> m_Empty;                           // canonical empty node per level, prebuilt
+
+    std::unique_ptr<ThreadPool> m_Pool;
+    unsigned int m_ParallelCutoff;
+    std::atomic<bool> m_OutOfMemory;
+
+    std::atomic<uint64_t> m_NodesCreated;
+    std::atomic<uint64_t> m_ResultHits;
+    std::atomic<uint64_t> m_ResultMisses;
+
+    std::size_t m_MemoryLimit;
+    std::size_t m_Capacity;
+    std::size_t m_LeafCapacity;
+
+    uint32_t m_Root;
+    unsigned int m_RootLevel;
+    unsigned int m_StepLog2;
+    uint64_t m_Generation;
+    uint32_t m_Epoch;
+    uint64_t m_NodeVersion;
+
+    HashlifeStats m_Stats;
+
+    std::mutex m_PinMutex;
+    std::condition_variable m_Unpinned;
+    unsigned int m_PinCount;
+    std::atomic<bool> m_PinWaiting;
+
+    uint32_t Join(uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se);
+    uint32_t FindLeaf(uint64_t bits);
+    uint64_t LeafBits(uint32_t leaf) const { return m_Leaves[leaf & 0x7FFFFFFFu]; }
+    uint32_t Empty(unsigned int level) const { return m_Empty[level]; }
+    bool IsParallel(unsigned int level) const;
+    void FlushCounters();
+    void WaitForUnpin();
+
+    uint32_t Centre(uint32_t node, unsigned int level);
+    bool NinePieces(uint32_t node, uint32_t pieces[9]);
+    uint32_t CombineAndAdvance(const uint32_t parts[9], unsigned int level);
+    uint32_t Advance(uint32_t node, unsigned int level);
+    uint32_t FullResult(uint32_t node, unsigned int level);
+    uint32_t SlowResult(uint32_t node, unsigned int level);
+    uint32_t LeafResult(uint32_t node, unsigned int generations);
+
+    bool ExpandRoot();
+    void ShrinkRoot();
+    bool RootHasBorder() const;
+    bool StepWithRetry(unsigned int stepLog2);
+    bool StepOnce(unsigned int stepLog2);
+    void SetStepLog2(unsigned int stepLog2);
+
+    uint32_t SetCellRecursive(uint32_t node, unsigned int level, uint64_t x, uint64_t y, bool alive);
+    uint64_t CountPopulation(uint32_t node, unsigned int level, std::unordered_map<uint32_t, uint64_t>& memo) const;
+
+    void Mark(uint32_t node, unsigned int level, MarkState& state) const;
+    void Compact(const MarkState& state);
+    void RebuildTables();
+    static void FillTables(const Node* nodes, uint32_t count, const uint64_t* leaves, uint32_t leafCount,
+                           HashTable& nodeTable, HashTable& leafTable);
+    static StoreLayout ComputeLayout(std::size_t capacity, std::size_t leafCapacity);
+    static std::size_t CapacityFor(std::size_t memoryLimit);
+    StoreLayout ImageLayout() const;
+    static bool IsValidStore(const MappedFile& file);
+    bool AllocatePools(std::size_t capacity, std::size_t leafCapacity);
+    bool GrowPools();
+    void MapPools(const StoreLayout& layout);
+    void AdoptStorage();
+    void FillHeader(StoreHeader& header, std::size_t capacity, std::size_t leafCapacity, bool clean) const;
+    void WriteHeader(bool clean);
+    void MaybeCollect();
+};
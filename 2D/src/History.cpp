@@ -0,0 +1,226 @@
+#include "History.h"
+#include "Hashlife.h"
+
+#include <algorithm>
+#include <iostream>
+
+static void PutVarint(std::vector<uint8_t>& data, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        data.push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    data.push_back((uint8_t)value);
+}
+
+static uint64_t GetVarint(const uint8_t*& p)
+{
+    uint64_t value = 0;
+    for (unsigned int shift = 0;; shift += 7)
+    {
+        uint8_t byte = *p++;
+        value |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+            return value;
+    }
+}
+
+// Zigzag so small negative deltas stay small
+static uint64_t ToUnsigned(int64_t value)
+{
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static int64_t ToSigned(uint64_t value)
+{
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+History::History(unsigned int keyframeInterval, std::size_t memoryBudget)
+    :m_KeyframeInterval(std::max(keyframeInterval, 1u)), m_MemoryBudget(memoryBudget), m_MemoryUse(0),
+     m_SinceKeyframe(0), m_LastGeneration(0), m_HasLast(false)
+{
+}
+
+void History::Record(const Hashlife& life)
+{
+    uint64_t generation = life.GetGeneration();
+    if (m_HasLast && generation == m_LastGeneration)
+        return;
+    // Running on from an earlier generation starts a new timeline, anything
+    // else going backwards (a new pattern, say) starts over
+    if (m_HasLast)
+        Truncate(m_LastGeneration);
+    if (!m_Entries.empty() && m_Entries.back().generation >= generation)
+    {
+        m_Entries.clear();
+        m_MemoryUse = 0;
+        m_HasLast = false;
+    }
+
+    std::vector<PatternTile> tiles;
+    CaptureTiles(life, tiles);
+
+    Entry entry;
+    entry.generation = generation;
+    entry.keyframe = !m_HasLast || m_SinceKeyframe + 1 >= m_KeyframeInterval;
+    if (entry.keyframe)
+    {
+        Encode(tiles, entry.data);
+        m_SinceKeyframe = 0;
+    }
+    else
+    {
+        std::vector<PatternTile> changed;
+        XorTiles(m_Last, tiles, changed);
+        Encode(changed, entry.data);
+        m_SinceKeyframe++;
+    }
+    entry.data.shrink_to_fit();
+    m_MemoryUse += entry.data.capacity();
+    m_Entries.push_back(std::move(entry));
+
+    m_Last.swap(tiles);
+    m_LastGeneration = generation;
+    m_HasLast = true;
+    Evict();
+}
+
+bool History::Seek(uint64_t generation, Hashlife& life)
+{
+    auto it = std::lower_bound(m_Entries.begin(), m_Entries.end(), generation,
+                               [](const Entry& entry, uint64_t g) { return entry.generation < g; });
+    if (it == m_Entries.end() || it->generation != generation)
+        return false;
+
+    auto keyframe = it;
+    while (!keyframe->keyframe)
+        --keyframe;
+
+    std::vector<PatternTile> tiles, changed, next;
+    Decode(keyframe->data, tiles);
+    for (auto delta = keyframe + 1; delta != it + 1; ++delta)
+    {
+        Decode(delta->data, changed);
+        XorTiles(tiles, changed, next);
+        tiles.swap(next);
+    }
+
+    if (!BuildTiles(tiles, generation, life))
+    {
+        std::cerr << "History: no room to restore generation " << generation << std::endl;
+        return false;
+    }
+    m_Last.swap(tiles);
+    m_LastGeneration = generation;
+    m_HasLast = true;
+    return true;
+}
+
+bool History::Earlier(uint64_t generation, uint64_t& found) const
+{
+    auto it = std::lower_bound(m_Entries.begin(), m_Entries.end(), generation,
+                               [](const Entry& entry, uint64_t g) { return entry.generation < g; });
+    if (it == m_Entries.begin())
+        return false;
+    found = (--it)->generation;
+    return true;
+}
+
+bool History::Later(uint64_t generation, uint64_t& found) const
+{
+    auto it = std::upper_bound(m_Entries.begin(), m_Entries.end(), generation,
+                               [](uint64_t g, const Entry& entry) { return g < entry.generation; });
+    if (it == m_Entries.end())
+        return false;
+    found = it->generation;
+    return true;
+}
+
+/**
+ * Per tile: band delta, column delta (from 0 on a new band), a byte with a
+ * bit per non-zero row, then those rows. Changed tiles are usually a few
+ * cells, so they come out at four or five bytes.
+ */
+void History::Encode(const std::vector<PatternTile>& tiles, std::vector<uint8_t>& data)
+{
+    data.clear();
+    PutVarint(data, tiles.size());
+    int64_t band = 0, column = 0;
+    for (const PatternTile& tile : tiles)
+    {
+        if (tile.band != band)
+            column = 0;
+        PutVarint(data, ToUnsigned(tile.band - band));
+        PutVarint(data, ToUnsigned(tile.column - column));
+        band = tile.band;
+        column = tile.column;
+
+        uint8_t rows = 0;
+        for (unsigned int r = 0; r < 8; r++)
+            if ((tile.bits >> (r * 8)) & 0xFF)
+                rows |= (uint8_t)(1 << r);
+        data.push_back(rows);
+        for (unsigned int r = 0; r < 8; r++)
+            if (rows & (1 << r))
+                data.push_back((uint8_t)(tile.bits >> (r * 8)));
+    }
+}
+
+void History::Decode(const std::vector<uint8_t>& data, std::vector<PatternTile>& tiles)
+{
+    tiles.clear();
+    const uint8_t* p = data.data();
+    uint64_t count = GetVarint(p);
+    tiles.reserve(count);
+    int64_t band = 0, column = 0;
+    for (uint64_t i = 0; i < count; i++)
+    {
+        int64_t nextBand = band + ToSigned(GetVarint(p));
+        if (nextBand != band)
+            column = 0;
+        band = nextBand;
+        column += ToSigned(GetVarint(p));
+
+        uint8_t rows = *p++;
+        uint64_t bits = 0;
+        for (unsigned int r = 0; r < 8; r++)
+            if (rows & (1 << r))
+                bits |= (uint64_t)*p++ << (r * 8);
+        tiles.push_back({ column, band, bits });
+    }
+}
+
+// Drops everything recorded after `generation`
+void History::Truncate(uint64_t generation)
+{
+    bool dropped = false;
+    while (!m_Entries.empty() && m_Entries.back().generation > generation)
+    {
+        m_MemoryUse -= m_Entries.back().data.capacity();
+        m_Entries.pop_back();
+        dropped = true;
+    }
+    if (!dropped)
+        return;
+
+    m_SinceKeyframe = 0;
+    for (auto it = m_Entries.rbegin(); it != m_Entries.rend() && !it->keyframe; ++it)
+        m_SinceKeyframe++;
+}
+
+// Oldest first, a keyframe always goes together with its deltas
+void History::Evict()
+{
+    while (m_MemoryUse > m_MemoryBudget)
+    {
+        if (std::none_of(m_Entries.begin() + 1, m_Entries.end(), [](const Entry& entry) { return entry.keyframe; }))
+            return;     // only the newest keyframe is left
+        do
+        {
+            m_MemoryUse -= m_Entries.front().data.capacity();
+            m_Entries.pop_front();
+        } while (!m_Entries.front().keyframe);
+    }
+}
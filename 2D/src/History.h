@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "PatternTiles.h"
+
+class Hashlife;
+
+/**
+ * Rewind buffer of recorded generations.
+ *
+ * Every `keyframeInterval`-th record is a keyframe holding every live 8x8
+ * tile, the records in between only hold the tiles that changed, XORed with
+ * their previous contents. Both are packed the same way: position deltas as
+ * varints, then a mask of the tile's non-zero rows and just those row bytes.
+ *
+ * Seeking decodes one keyframe, XORs in at most keyframeInterval - 1 deltas
+ * and rebuilds the engine's tree from the result. Recording walks the live
+ * pattern once, so it costs time in proportion to the live tiles.
+ *
+ * When the packed records go over the memory budget the oldest keyframe and
+ * its deltas are dropped together. Recording after a seek drops everything
+ * newer than the generation that was sought, like undo.
+ */
+class History
+{
+public:
+    static constexpr unsigned int DefaultKeyframeInterval = 32;
+    static constexpr std::size_t DefaultMemoryBudget = (std::size_t)256 << 20;
+
+    History(unsigned int keyframeInterval = DefaultKeyframeInterval, std::size_t memoryBudget = DefaultMemoryBudget);
+
+    // Does nothing if the engine is still on the last recorded generation
+    void Record(const Hashlife& life);
+    // Puts the engine back to a recorded generation, false if it isn't kept
+    bool Seek(uint64_t generation, Hashlife& life);
+
+    // Recorded generation next to `generation`, false at either end
+    bool Earlier(uint64_t generation, uint64_t& found) const;
+    bool Later(uint64_t generation, uint64_t& found) const;
+
+    bool IsEmpty() const { return m_Entries.empty(); }
+    std::size_t GetEntryCount() const { return m_Entries.size(); }
+    std::size_t GetMemoryUse() const { return m_MemoryUse; }
+
+private:
+    struct Entry
+    {
+        uint64_t generation;
+        bool keyframe;
+        std::vector<uint8_t> data;
+    };
+
+    unsigned int m_KeyframeInterval;
+    std::size_t m_MemoryBudget;
+    std::size_t m_MemoryUse;
+    std::deque<Entry> m_Entries;
+    unsigned int m_SinceKeyframe;         // deltas recorded since the newest keyframe
+
+    std::vector<PatternTile> m_Last;      // tiles of the last recorded or sought generation
+    uint64_t m_LastGeneration;
+    bool m_HasLast;
+
+    static void Encode(const std::vector<PatternTile>& tiles, std::vector<uint8_t>& data);
+    static void Decode(const std::vector<uint8_t>& data, std::vector<PatternTile>& tiles);
+
+    void Truncate(uint64_t generation);
+    void Evict();
+};
@@ -0,0 +1,143 @@
+#include "HyperspeedController.h"
+
+#include <algorithm>
+#include <chrono>
+
+// Weight of a new measurement in the smoothed cost
+static const double CostSmoothing = 0.3;
+// Frames before a cost estimate is old enough to probe that size again
+static const uint64_t StaleFrames = 120;
+// Frames a memory ceiling holds before larger steps are tried again
+static const uint64_t CeilingFrames = 600;
+// Below this share of hits a bigger step is expected to create a lot more nodes
+static const double MinHitRate = 0.5;
+// A step creating more than 1/n of the free pool is too big
+static const uint64_t HeadroomShare = 4;
+// The smaller step has to be this much cheaper per generation to shrink
+static const double ShrinkMargin = 0.8;
+
+HyperspeedController::HyperspeedController(double frameBudgetMs)
+    : m_FrameBudgetMs(frameBudgetMs), m_MaxStepLog2(Hashlife::MaxStepLog2), m_StepLog2(0),
+      m_MemoryCeiling(Hashlife::MaxStepLog2), m_CeilingFrame(0), m_StepMs(0.0), m_Warm(false),
+      m_Frame(0), m_FrameGenerations(0), m_FrameMs(0.0)
+{
+}
+
+void HyperspeedController::SetMaxStepLog2(unsigned int maxStepLog2)
+{
+    m_MaxStepLog2 = std::min(maxStepLog2, Hashlife::MaxStepLog2);
+    if (m_StepLog2 > m_MaxStepLog2)
+        SetStepLog2(m_MaxStepLog2);
+}
+
+bool HyperspeedController::RunFrame(Hashlife& life)
+{
+    using Clock = std::chrono::steady_clock;
+    auto frameStart = Clock::now();
+    m_Frame++;
+    m_FrameGenerations = 0;
+    if (m_MemoryCeiling < m_MaxStepLog2 && m_Frame - m_CeilingFrame > CeilingFrames)
+        m_MemoryCeiling = m_MaxStepLog2;
+
+    // Always at least one step, then keep going while the next one should fit
+    while (true)
+    {
+        HashlifeStats before = life.GetStats();
+        uint64_t generation = life.GetGeneration();
+        unsigned int stepLog2 = m_StepLog2;
+        auto stepStart = Clock::now();
+        bool stepped = life.Step(stepLog2);
+        // A failed step can have got partway as smaller steps, that still counts
+        m_FrameGenerations += life.GetGeneration() - generation;
+        if (!stepped)
+            return false;
+        auto stepEnd = Clock::now();
+        const HashlifeStats& after = life.GetStats();
+
+        double stepMs = std::chrono::duration<double, std::milli>(stepEnd - stepStart).count();
+        uint64_t hits = after.resultHits - before.resultHits;
+        uint64_t lookups = hits + after.resultMisses - before.resultMisses;
+        double hitRate = lookups ? (double)hits / (double)lookups : 1.0;
+        uint64_t headroom = before.nodeCapacity > before.nodeCount ? before.nodeCapacity - before.nodeCount : 0;
+        bool retried = after.retries != before.retries;
+
+        Adapt(stepMs, after.nodesCreated - before.nodesCreated, headroom, hitRate, retried);
+
+        m_FrameMs = std::chrono::duration<double, std::milli>(stepEnd - frameStart).count();
+        if (m_FrameMs + m_StepMs > m_FrameBudgetMs)
+            break;
+    }
+    return true;
+}
+
+bool HyperspeedController::IsFresh(unsigned int stepLog2) const
+{
+    const StepCost& cost = m_Costs[stepLog2];
+    return cost.known && m_Frame - cost.frame < StaleFrames;
+}
+
+void HyperspeedController::SetStepLog2(unsigned int stepLog2)
+{
+    // Guess the next step time from the last one until it's measured
+    if (stepLog2 > m_StepLog2)
+        m_StepMs *= (double)((uint64_t)1 << (stepLog2 - m_StepLog2));
+    else
+        m_StepMs /= (double)((uint64_t)1 << (m_StepLog2 - stepLog2));
+    m_StepLog2 = stepLog2;
+    m_Warm = false;
+}
+
+void HyperspeedController::Adapt(double stepMs, uint64_t created, uint64_t headroom, double hitRate, bool retried)
+{
+    unsigned int step = m_StepLog2;
+    m_StepMs = stepMs;
+
+    if (step > 0)
+    {
+        // Memory pressure wins over everything, remember it for a while
+        if (retried || created > headroom / HeadroomShare)
+        {
+            m_MemoryCeiling = step - 1;
+            m_CeilingFrame = m_Frame;
+            SetStepLog2(step - 1);
+            return;
+        }
+        if (stepMs > m_FrameBudgetMs)
+        {
+            SetStepLog2(step - 1);
+            return;
+        }
+    }
+
+    // The first step at a new size runs with a cold step memo, don't judge it
+    if (!m_Warm)
+    {
+        m_Warm = true;
+        return;
+    }
+
+    StepCost& cost = m_Costs[step];
+    double msPerGeneration = stepMs / (double)((uint64_t)1 << step);
+    if (IsFresh(step))
+        cost.msPerGeneration += CostSmoothing * (msPerGeneration - cost.msPerGeneration);
+    else
+        cost.msPerGeneration = msPerGeneration;
+    cost.known = true;
+    cost.frame = m_Frame;
+
+    if (step > 0 && IsFresh(step - 1) && m_Costs[step - 1].msPerGeneration < cost.msPerGeneration * ShrinkMargin)
+    {
+        SetStepLog2(step - 1);
+        return;
+    }
+
+    if (step >= std::min(m_MaxStepLog2, m_MemoryCeiling))
+        return;
+    // A doubled step creates about twice the nodes, more when results aren't being reused
+    uint64_t expectedCreated = created * (hitRate >= MinHitRate ? 2 : 4);
+    bool fitsMemory = expectedCreated <= headroom / HeadroomShare;
+    bool fitsDoubled = stepMs * 2.0 <= m_FrameBudgetMs;
+    bool cheaperAbove = !IsFresh(step + 1) || m_Costs[step + 1].msPerGeneration < cost.msPerGeneration;
+    if (fitsMemory && fitsDoubled && cheaperAbove)
+        SetStepLog2(step + 1);
+}
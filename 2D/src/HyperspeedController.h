@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Hashlife.h"
+
+/**
+ * Picks the Hashlife step size for "run as fast as possible".
+ *
+ * Every frame runs steps of 2^j generations until the frame budget is spent.
+ * After each step the controller looks at how long it took, how many nodes it
+ * created and how often results were reused, then moves j:
+ *
+ *  - down when a step no longer fits in a frame, or when it forced a garbage
+ *    collection or ate a big part of the free node pool (too large a step
+ *    just churns memory),
+ *  - up when a doubled step would still fit, results are being reused and
+ *    the next size up isn't known to be slower per generation,
+ *  - down when the next size down is known to be cheaper per generation.
+ *
+ * Cost per generation is remembered per step size. Estimates go stale after a
+ * while so the controller keeps probing as the pattern changes.
+ */
+class HyperspeedController
+{
+public:
+    static constexpr double DefaultFrameBudgetMs = 12.0;
+
+    HyperspeedController(double frameBudgetMs = DefaultFrameBudgetMs);
+
+    void SetFrameBudget(double frameBudgetMs) { m_FrameBudgetMs = frameBudgetMs; }
+    double GetFrameBudget() const { return m_FrameBudgetMs; }
+    void SetMaxStepLog2(unsigned int maxStepLog2);
+
+    // Advances `life` by as many generations as fit in the budget, false if a step failed
+    bool RunFrame(Hashlife& life);
+
+    unsigned int GetStepLog2() const { return m_StepLog2; }
+    uint64_t GetFrameGenerations() const { return m_FrameGenerations; }
+    double GetFrameMs() const { return m_FrameMs; }
+
+private:
+    // Smoothed cost of one step of a given size and the frame it was measured in
+    struct StepCost
+    {
+        double msPerGeneration = 0.0;
+        uint64_t frame = 0;
+        bool known = false;
+    };
+
+    double m_FrameBudgetMs;
+    unsigned int m_MaxStepLog2;
+    unsigned int m_StepLog2;
+    unsigned int m_MemoryCeiling;      // largest step allowed after memory pressure
+    uint64_t m_CeilingFrame;
+
+    StepCost m_Costs[Hashlife::MaxStepLog2 + 1];
+    double m_StepMs;                   // expected time of the next step
+    bool m_Warm;                       // a step has already run at the current size
+
+    uint64_t m_Frame;
+    uint64_t m_FrameGenerations;
+    double m_FrameMs;
+
+    bool IsFresh(unsigned int stepLog2) const;
+    void SetStepLog2(unsigned int stepLog2);
+    void Adapt(double stepMs, uint64_t created, uint64_t headroom, double hitRate, bool retried);
+};
@@ -0,0 +1,276 @@
+#include "ImageFile.h"
+#include "Hashlife.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+// Nodes this big or bigger build their quadrants on separate threads
+static const unsigned int ParallelLevel = Hashlife::LeafLevel + 6;
+// Whole P4 blocks of 8x8 leaves are read a row word at a time
+static const unsigned int BlockLevel = Hashlife::LeafLevel + 3;
+
+struct Image
+{
+    const unsigned char* pixels;
+    uint64_t width;
+    uint64_t height;
+    std::size_t rowBytes;
+    bool bitmap;                 // P4, otherwise P5
+    unsigned int sampleBytes;    // P5 samples are 1 or 2 bytes, big endian
+    unsigned int cut;            // P5 samples below this are alive
+    int64_t columns;             // in leaves
+    int64_t bands;
+    int64_t fullColumns;         // leaves that are entirely inside the image
+    int64_t fullBands;
+    uint64_t lastMask;           // drops the padding bits of a P4 row's last byte
+};
+
+// Next number of the header, skipping whitespace and '#' comments
+static bool ReadNumber(const char*& p, const char* end, uint64_t& value)
+{
+    while (p < end && (std::isspace((unsigned char)*p) || *p == '#'))
+    {
+        if (*p == '#')
+            while (p < end && *p != '\n')
+                p++;
+        else
+            p++;
+    }
+    if (p == end || *p < '0' || *p > '9')
+        return false;
+    value = 0;
+    for (; p < end && *p >= '0' && *p <= '9'; p++)
+    {
+        value = value * 10 + (uint64_t)(*p - '0');
+        if (value > ((uint64_t)1 << 40))
+            return false;
+    }
+    return true;
+}
+
+static bool ReadHeader(const MappedFile& file, double threshold, Image& image)
+{
+    const char* p = (const char*)file.GetData();
+    const char* end = p + file.GetSize();
+    if (file.GetSize() < 2 || p[0] != 'P' || (p[1] != '4' && p[1] != '5'))
+        return false;
+    image.bitmap = p[1] == '4';
+    p += 2;
+
+    uint64_t maxValue = 1;
+    if (!ReadNumber(p, end, image.width) || !ReadNumber(p, end, image.height)
+        || (!image.bitmap && (!ReadNumber(p, end, maxValue) || maxValue == 0 || maxValue > 65535)))
+        return false;
+    // Exactly one whitespace byte before the pixels
+    if (p == end || !std::isspace((unsigned char)*p))
+        return false;
+    p++;
+
+    image.pixels = (const unsigned char*)p;
+    image.sampleBytes = maxValue > 255 ? 2 : 1;
+    // Sides go up to 2^40, so the sizes can wrap and have to be checked before they're compared with the file
+    std::size_t imageBytes = 0;
+    if (image.bitmap)
+        image.rowBytes = (std::size_t)(image.width + 7) / 8;
+    else if (__builtin_mul_overflow((std::size_t)image.width, (std::size_t)image.sampleBytes, &image.rowBytes))
+        return false;
+    if (__builtin_mul_overflow(image.rowBytes, (std::size_t)image.height, &imageBytes))
+        return false;
+    image.cut = (unsigned int)std::ceil(std::min(std::max(threshold, 0.0), 1.0) * (double)maxValue);
+    image.columns = (int64_t)(image.width + 7) / 8;
+    image.bands = (int64_t)(image.height + 7) / 8;
+    image.fullColumns = (int64_t)image.width / 8;
+    image.fullBands = (int64_t)image.height / 8;
+    unsigned int spare = (unsigned int)(image.width & 7);
+    image.lastMask = (spare ? (1u << spare) - 1 : 0xFFu) * 0x0101010101010101ull;
+    return (std::size_t)(end - p) >= imageBytes;
+}
+
+// P4 has the leftmost pixel in a byte's top bit, leaves have it in the bottom one
+static inline uint64_t ReverseBytes(uint64_t bits)
+{
+    bits = ((bits >> 1) & 0x5555555555555555ull) | ((bits & 0x5555555555555555ull) << 1);
+    bits = ((bits >> 2) & 0x3333333333333333ull) | ((bits & 0x3333333333333333ull) << 2);
+    return ((bits >> 4) & 0x0F0F0F0F0F0F0F0Full) | ((bits & 0x0F0F0F0F0F0F0F0Full) << 4);
+}
+
+static uint64_t BitmapLeaf(const Image& image, int64_t column, int64_t band)
+{
+    uint64_t y = (uint64_t)band * 8;
+    unsigned int rows = (unsigned int)std::min<uint64_t>(8, image.height - y);
+    const unsigned char* p = image.pixels + y * image.rowBytes + (std::size_t)column;
+    uint64_t bits = 0;
+    for (unsigned int r = 0; r < rows; r++, p += image.rowBytes)
+        bits |= (uint64_t)*p << (r * 8);
+    bits = ReverseBytes(bits);
+    if (column == image.columns - 1)
+        bits &= image.lastMask;
+    return bits;
+}
+
+static uint64_t GreyLeaf(const Image& image, int64_t column, int64_t band)
+{
+    uint64_t y = (uint64_t)band * 8;
+    uint64_t x = (uint64_t)column * 8;
+    unsigned int rows = (unsigned int)std::min<uint64_t>(8, image.height - y);
+    unsigned int cells = (unsigned int)std::min<uint64_t>(8, image.width - x);
+    uint64_t bits = 0;
+    for (unsigned int r = 0; r < rows; r++)
+    {
+        const unsigned char* p = image.pixels + (y + r) * image.rowBytes + x * image.sampleBytes;
+        for (unsigned int c = 0; c < cells; c++, p += image.sampleBytes)
+        {
+            unsigned int sample = image.sampleBytes == 2 ? (unsigned int)p[0] << 8 | p[1] : *p;
+            if (sample < image.cut)
+                bits |= (uint64_t)1 << (r * 8 + c);
+        }
+    }
+    return bits;
+}
+
+// Parent of four nodes, 0 if the engine is full
+static uint32_t Join(Hashlife& life, unsigned int level, uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se)
+{
+    if (!nw || !ne || !sw || !se)
+        return 0;
+    // Blank areas are common in seed images and need no table lookup
+    uint32_t e = life.EmptyNode(level - 1);
+    if (nw == e && ne == e && sw == e && se == e)
+        return life.EmptyNode(level);
+    return life.MakeNode(nw, ne, sw, se);
+}
+
+static uint32_t Leaf(Hashlife& life, uint64_t bits)
+{
+    return bits ? life.MakeLeaf(bits) : life.EmptyNode(Hashlife::LeafLevel);
+}
+
+/**
+ * 64x64 cells of a P4 image that are all inside it. Each band's eight row
+ * words are an 8x8 byte matrix with one leaf per column, transposing it
+ * turns the rows into leaves. That beats gathering every leaf from eight
+ * rows a byte at a time.
+ */
+static uint32_t BitmapBlock(const Image& image, Hashlife& life, int64_t x, int64_t y)
+{
+    uint32_t grid[8][8];
+    for (unsigned int j = 0; j < 8; j++)
+    {
+        uint64_t a[8];
+        const unsigned char* p = image.pixels + (std::size_t)(y + j) * 8 * image.rowBytes + (std::size_t)x;
+        for (unsigned int r = 0; r < 8; r++, p += image.rowBytes)
+            std::memcpy(&a[r], p, 8);
+
+        // Swap 4x4, then 2x2, then 1x1 blocks of bytes across the diagonal
+        for (unsigned int r = 0; r < 4; r++)
+        {
+            uint64_t t = ((a[r] >> 32) ^ a[r + 4]) & 0x00000000FFFFFFFFull;
+            a[r] ^= t << 32;
+            a[r + 4] ^= t;
+        }
+        for (unsigned int r : { 0u, 1u, 4u, 5u })
+        {
+            uint64_t t = ((a[r] >> 16) ^ a[r + 2]) & 0x0000FFFF0000FFFFull;
+            a[r] ^= t << 16;
+            a[r + 2] ^= t;
+        }
+        for (unsigned int r = 0; r < 8; r += 2)
+        {
+            uint64_t t = ((a[r] >> 8) ^ a[r + 1]) & 0x00FF00FF00FF00FFull;
+            a[r] ^= t << 8;
+            a[r + 1] ^= t;
+        }
+        for (unsigned int i = 0; i < 8; i++)
+            grid[j][i] = Leaf(life, ReverseBytes(a[i]));
+    }
+
+    // Pairs of pairs up to one node, in place
+    unsigned int level = Hashlife::LeafLevel;
+    for (unsigned int size = 4; size >= 1; size /= 2)
+    {
+        level++;
+        for (unsigned int j = 0; j < size; j++)
+            for (unsigned int i = 0; i < size; i++)
+                grid[j][i] = Join(life, level, grid[2 * j][2 * i], grid[2 * j][2 * i + 1],
+                                  grid[2 * j + 1][2 * i], grid[2 * j + 1][2 * i + 1]);
+    }
+    return grid[0][0];
+}
+
+// Node of `level` whose top left leaf is image leaf (x, y), 0 if the engine is full
+static uint32_t Build(const Image& image, Hashlife& life, ThreadPool& pool, unsigned int level, int64_t x, int64_t y)
+{
+    int64_t size = (int64_t)1 << (level - Hashlife::LeafLevel);
+    if (x >= image.columns || y >= image.bands || x + size <= 0 || y + size <= 0)
+        return life.EmptyNode(level);
+    if (level == Hashlife::LeafLevel)
+        return Leaf(life, image.bitmap ? BitmapLeaf(image, x, y) : GreyLeaf(image, x, y));
+    if (level == BlockLevel && image.bitmap && x >= 0 && y >= 0 && x + 8 <= image.fullColumns
+        && y + 8 <= image.fullBands)
+        return BitmapBlock(image, life, x, y);
+
+    int64_t half = size / 2;
+    uint32_t children[4];
+    auto child = [&](unsigned int i)
+    {
+        children[i] = Build(image, life, pool, level - 1, x + (i & 1) * half, y + (i >> 1) * half);
+    };
+    if (level >= ParallelLevel)
+        pool.Run(4, child);
+    else
+        for (unsigned int i = 0; i < 4; i++)
+            child(i);
+
+    return Join(life, level, children[0], children[1], children[2], children[3]);
+}
+
+bool LoadImage(const std::string& path, Hashlife& life, double threshold)
+{
+    auto start = std::chrono::steady_clock::now();
+    MappedFile file;
+    if (!file.Open(path, false))
+    {
+        std::cerr << "Failed to open pattern file: " << path << std::endl;
+        return false;
+    }
+    Image image;
+    if (!ReadHeader(file, threshold, image))
+    {
+        std::cerr << "Not a binary PBM (P4) or PGM (P5) image, or it's cut short: " << path << std::endl;
+        return false;
+    }
+
+    // Smallest square of leaves that holds the image, with the image in its middle
+    unsigned int level = Hashlife::LeafLevel + 1;
+    while (((int64_t)1 << (level - Hashlife::LeafLevel)) < std::max(image.columns, image.bands))
+        level++;
+    if (level > 62)
+    {
+        std::cerr << "Image is too large: " << path << std::endl;
+        return false;
+    }
+    int64_t size = (int64_t)1 << (level - Hashlife::LeafLevel);
+
+    life.BeginLoad();
+    ThreadPool pool(life.GetThreadCount());
+    uint32_t root = Build(image, life, pool, level, -((size - image.columns) / 2), -((size - image.bands) / 2));
+    if (!root || !life.EndLoad(root, level))
+    {
+        if (!root)
+            life.EndLoad(0, 0);
+        std::cerr << "Image doesn't fit in the Hashlife memory limit: " << path << std::endl;
+        return false;
+    }
+
+    auto finish = std::chrono::steady_clock::now();
+    std::cout << "Loaded image: " << path << " (" << image.width << "x" << image.height << ") in "
+              << std::chrono::duration<double, std::milli>(finish - start).count() << " ms on "
+              << pool.GetThreadCount() << " threads" << std::endl;
+    return true;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <string>
+
+class Hashlife;
+
+/**
+ * Binary Netpbm images as patterns: PBM (P4) black pixels and PGM (P5)
+ * pixels darker than `threshold` (0 to 1 of the image's white level) are
+ * alive.
+ *
+ * The file is mapped and the tree is built straight from it, top down and in
+ * parallel. A P4 row is already one bit per pixel, so a leaf is eight row
+ * bytes read from the mapping and bit-reversed in one go, no cell is handled
+ * on its own. A loaded image replaces the universe and is centred on the
+ * origin (to the nearest 8 cells, which keeps image bytes and leaf rows
+ * aligned).
+ */
+bool LoadImage(const std::string& path, Hashlife& life, double threshold = 0.5);
@@ -0,0 +1,143 @@
+#include "Life106File.h"
+#include "ChunkedLoader.h"
+#include "Hashlife.h"
+#include "MappedFile.h"
+#include "PatternTiles.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+// Far enough inside int64 that tile maths can't overflow
+static const int64_t MaxCoordinate = (int64_t)1 << 60;
+
+static bool ParseNumber(const char*& p, const char* end, int64_t& value)
+{
+    while (p < end && (*p == ' ' || *p == '\t'))
+        p++;
+    bool negative = p < end && *p == '-';
+    if (p < end && (*p == '-' || *p == '+'))
+        p++;
+    if (p == end || *p < '0' || *p > '9')
+        return false;
+    value = 0;
+    for (; p < end && *p >= '0' && *p <= '9'; p++)
+    {
+        value = value * 10 + (*p - '0');
+        if (value > MaxCoordinate)
+            return false;
+    }
+    if (negative)
+        value = -value;
+    return true;
+}
+
+// One chunk of lines to a sorted list of tiles, false on a line that isn't a coordinate pair
+static bool ParseChunk(const TextChunk& chunk, std::vector<PatternTile>& tiles)
+{
+    for (const char* p = chunk.begin; p < chunk.end;)
+    {
+        const char* end = (const char*)std::memchr(p, '\n', (std::size_t)(chunk.end - p));
+        const char* next = end ? end + 1 : chunk.end;
+        if (!end)
+            end = chunk.end;
+        while (end > p && (end[-1] == '\r' || end[-1] == ' ' || end[-1] == '\t'))
+            end--;
+
+        int64_t x = 0, y = 0;
+        if (p < end && *p != '#')
+        {
+            if (!ParseNumber(p, end, x) || !ParseNumber(p, end, y) || p != end)
+                return false;
+            // Cells usually come in reading order, so most land in the tile before
+            int64_t column = x >> 3, band = y >> 3;
+            uint64_t bit = (uint64_t)1 << ((y & 7) * 8 + (x & 7));
+            if (!tiles.empty() && tiles.back().column == column && tiles.back().band == band)
+                tiles.back().bits |= bit;
+            else
+                tiles.push_back({ column, band, bit });
+        }
+        p = next;
+    }
+
+    std::sort(tiles.begin(), tiles.end(), [](const PatternTile& a, const PatternTile& b)
+    {
+        return a.band < b.band || (a.band == b.band && a.column < b.column);
+    });
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < tiles.size(); i++)
+    {
+        if (count && tiles[count - 1].column == tiles[i].column && tiles[count - 1].band == tiles[i].band)
+            tiles[count - 1].bits |= tiles[i].bits;
+        else
+            tiles[count++] = tiles[i];
+    }
+    tiles.resize(count);
+    return true;
+}
+
+bool LoadLife106(const std::string& path, Hashlife& life)
+{
+    auto start = std::chrono::steady_clock::now();
+    MappedFile file;
+    if (!file.Open(path, false))
+    {
+        std::cerr << "Failed to open pattern file: " << path << std::endl;
+        return false;
+    }
+
+    const char* data = (const char*)file.GetData();
+    static const char Header[] = "#Life 1.06";
+    if (file.GetSize() < sizeof(Header) - 1 || std::memcmp(data, Header, sizeof(Header) - 1) != 0)
+    {
+        std::cerr << "Not a Life 1.06 file: " << path << std::endl;
+        return false;
+    }
+
+    ThreadPool pool(life.GetThreadCount());
+    std::vector<TextChunk> chunks = SplitText(data, file.GetSize(), '\n');
+    std::vector<std::vector<PatternTile>> parts(chunks.size());
+    std::atomic<bool> valid(true);
+    pool.Run((unsigned int)chunks.size(), [&](unsigned int i)
+    {
+        if (!ParseChunk(chunks[i], parts[i]))
+            valid = false;
+    });
+    if (!valid)
+    {
+        std::cerr << "Life 1.06: bad coordinate line in " << path << std::endl;
+        return false;
+    }
+
+    // Pairs of sorted lists merge side by side, half as many lists each round
+    for (std::size_t step = 1; step < parts.size(); step *= 2)
+    {
+        pool.Run((unsigned int)((parts.size() + 2 * step - 1) / (2 * step)), [&](unsigned int i)
+        {
+            std::size_t a = i * 2 * step, b = a + step;
+            if (b >= parts.size())
+                return;
+            std::vector<PatternTile> merged;
+            OrTiles(parts[a], parts[b], merged);
+            parts[a].swap(merged);
+            std::vector<PatternTile>().swap(parts[b]);
+        });
+    }
+
+    std::vector<PatternTile> empty;
+    if (!BuildTiles(parts.empty() ? empty : parts[0], 0, life, &pool))
+    {
+        std::cerr << "Failed to load pattern: " << path << std::endl;
+        return false;
+    }
+
+    auto finish = std::chrono::steady_clock::now();
+    std::cout << "Loaded pattern: " << path << " in "
+              << std::chrono::duration<double, std::milli>(finish - start).count() << " ms on "
+              << pool.GetThreadCount() << " threads" << std::endl;
+    return true;
+}
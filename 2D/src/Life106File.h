@@ -0,0 +1,15 @@
+#pragma once
+
+#include <string>
+
+class Hashlife;
+
+/**
+ * Life 1.06 patterns (.lif, .life): a "#Life 1.06" line, then one "x y" pair
+ * per live cell. Coordinates are absolute, so the pattern keeps its place.
+ *
+ * Cells can come in any order, so chunks of lines are parsed into sorted
+ * tile lists in parallel, the lists are merged pairwise in parallel and the
+ * result is built like a History keyframe.
+ */
+bool LoadLife106(const std::string& path, Hashlife& life);
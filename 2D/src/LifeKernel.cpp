@@ -0,0 +1,69 @@
+#include "LifeKernel.h"
+
+// Ripple one more addend into a 4-bit counter spread over four bit-planes
+static inline void AddBit(uint16_t& b0, uint16_t& b1, uint16_t& b2, uint16_t& b3, uint16_t x)
+{
+    uint16_t c0 = b0 & x;
+    b0 ^= x;
+    uint16_t c1 = b1 & c0;
+    b1 ^= c0;
+    uint16_t c2 = b2 & c1;
+    b2 ^= c1;
+    b3 |= c2;
+}
+
+uint64_t StepLeafBlock(uint64_t nw, uint64_t ne, uint64_t sw, uint64_t se,
+                       unsigned int generations, unsigned int birthMask, unsigned int surviveMask)
+{
+    uint16_t rows[16];
+    for (int y = 0; y < 8; y++)
+    {
+        rows[y] = (uint16_t)(((nw >> (8 * y)) & 0xFF) | (((ne >> (8 * y)) & 0xFF) << 8));
+        rows[y + 8] = (uint16_t)(((sw >> (8 * y)) & 0xFF) | (((se >> (8 * y)) & 0xFF) << 8));
+    }
+
+    // Each generation the outermost ring goes stale, after four the centre
+    // 8x8 is the last part that is still exact.
+    for (unsigned int g = 0; g < generations; g++)
+    {
+        uint16_t next[16];
+        next[0] = 0;
+        next[15] = 0;
+        for (int y = 1; y < 15; y++)
+        {
+            uint16_t up = rows[y - 1];
+            uint16_t mid = rows[y];
+            uint16_t down = rows[y + 1];
+
+            uint16_t b0 = 0, b1 = 0, b2 = 0, b3 = 0;
+            AddBit(b0, b1, b2, b3, (uint16_t)(up << 1));
+            AddBit(b0, b1, b2, b3, up);
+            AddBit(b0, b1, b2, b3, (uint16_t)(up >> 1));
+            AddBit(b0, b1, b2, b3, (uint16_t)(mid << 1));
+            AddBit(b0, b1, b2, b3, (uint16_t)(mid >> 1));
+            AddBit(b0, b1, b2, b3, (uint16_t)(down << 1));
+            AddBit(b0, b1, b2, b3, down);
+            AddBit(b0, b1, b2, b3, (uint16_t)(down >> 1));
+
+            uint16_t born = 0;
+            uint16_t survive = 0;
+            for (unsigned int count = 0; count <= 8; count++)
+            {
+                uint16_t match = (uint16_t)((count & 1 ? b0 : ~b0) & (count & 2 ? b1 : ~b1)
+                                          & (count & 4 ? b2 : ~b2) & (count & 8 ? b3 : ~b3));
+                if (birthMask & (1u << count))
+                    born |= match;
+                if (surviveMask & (1u << count))
+                    survive |= match;
+            }
+            next[y] = (uint16_t)((born & ~mid) | (survive & mid));
+        }
+        for (int y = 0; y < 16; y++)
+            rows[y] = next[y];
+    }
+
+    uint64_t result = 0;
+    for (int y = 0; y < 8; y++)
+        result |= (uint64_t)((rows[y + 4] >> 4) & 0xFF) << (8 * y);
+    return result;
+}
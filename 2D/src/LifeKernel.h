@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * Bit-parallel Life kernel for 8x8 leaf bitmaps.
+ *
+ * A leaf stores row r (top to bottom) in byte r and column c (west to east)
+ * in bit c of that byte.
+ *
+ * Four leaves make a 16x16 block held as sixteen 16-bit rows. Neighbour counts
+ * are summed with bit-sliced adders so one row operation handles sixteen
+ * cells, and the loop over rows is written so the compiler can vectorise it.
+ */
+
+// Centre 8x8 of the 16x16 block after `generations` steps (at most 4).
+uint64_t StepLeafBlock(uint64_t nw, uint64_t ne, uint64_t sw, uint64_t se,
+                       unsigned int generations, unsigned int birthMask, unsigned int surviveMask);
+
+// Centre 8x8 of the 16x16 block, no time passes.
+inline uint64_t CentreLeaf(uint64_t nw, uint64_t ne, uint64_t sw, uint64_t se)
+{
+    const uint64_t low = 0x0F0F0F0Full;
+    uint64_t top = (((nw >> 32) >> 4) & low) | (((ne >> 32) & low) << 4);
+    uint64_t bottom = ((sw >> 4) & low) | ((se & low) << 4);
+    return top | (bottom << 32);
+}
@@ -0,0 +1,400 @@
+#include "MacrocellFile.h"
+#include "Hashlife.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+static const std::size_t ChunkSize = 1 << 20;
+
+// Lays four square blocks of `half` cells out as one block in leaf layout
+static uint64_t ComposeBlock(uint64_t nw, uint64_t ne, uint64_t sw, uint64_t se, unsigned int half)
+{
+    return nw | (ne << half) | (sw << (8 * half)) | (se << (8 * half + half));
+}
+
+static bool ParseNumber(const char*& p, const char* end, uint64_t& value)
+{
+    while (p < end && (*p == ' ' || *p == '\t'))
+        p++;
+    if (p == end || *p < '0' || *p > '9')
+        return false;
+    value = 0;
+    for (; p < end && *p >= '0' && *p <= '9'; p++)
+        value = value * 10 + (uint64_t)(*p - '0');
+    return true;
+}
+
+/**
+ * Turns lines into nodes as they are read. Lines are numbered from 1 and a
+ * node may only point at lines before it, so one pass is enough. Levels 1
+ * and 2 only show up in multi-state files, those blocks are kept as bits
+ * until they add up to a leaf.
+ */
+class MacrocellDecoder
+{
+public:
+    MacrocellDecoder(Hashlife& life)
+        : m_Life(life), m_Generation(0), m_SeenHeader(false)
+    {
+        // Line 0 is the empty node
+        m_Levels.push_back(0);
+        m_Refs.push_back(0);
+    }
+
+    bool ParseLine(const char* p, const char* end);
+    bool Finish();
+
+private:
+    Hashlife& m_Life;
+    std::vector<uint8_t> m_Levels;
+    std::vector<uint32_t> m_Refs;      // engine node, or an index into m_Blocks below level 3
+    std::vector<uint64_t> m_Blocks;
+    uint64_t m_Generation;
+    bool m_SeenHeader;
+
+    bool Fail(const std::string& message) const
+    {
+        std::cerr << "Macrocell node " << m_Refs.size() << ": " << message << std::endl;
+        return false;
+    }
+    uint64_t BlockBits(uint64_t line) const
+    {
+        return line ? m_Blocks[m_Refs[line]] : 0;
+    }
+    bool ParseLeaf(const char* p, const char* end);
+    bool ParseNode(const char* p, const char* end);
+};
+
+bool MacrocellDecoder::ParseLine(const char* p, const char* end)
+{
+    while (end > p && (end[-1] == '\r' || end[-1] == ' '))
+        end--;
+    if (p == end)
+        return true;
+
+    if (!m_SeenHeader)
+    {
+        m_SeenHeader = true;
+        if (end - p < 4 || std::string(p, 4) != "[M2]")
+            return Fail("not a Macrocell file");
+        return true;
+    }
+
+    if (*p == '#')
+    {
+        std::string line(p, end);
+        if (line.compare(0, 2, "#R") == 0)
+        {
+            std::string rule;
+            for (char c : line.substr(2))
+                if (!std::isspace((unsigned char)c))
+                    rule += (char)std::tolower((unsigned char)c);
+            if (rule != "b3/s23" && rule != "23/3")
+                std::cerr << "Macrocell: rule" << line.substr(2) << " isn't supported, running it as B3/S23" << std::endl;
+        }
+        else if (line.compare(0, 2, "#G") == 0)
+            m_Generation = std::strtoull(line.c_str() + 2, nullptr, 10);
+        return true;
+    }
+    if (*p == '.' || *p == '*' || *p == '$')
+        return ParseLeaf(p, end);
+    return ParseNode(p, end);
+}
+
+bool MacrocellDecoder::ParseLeaf(const char* p, const char* end)
+{
+    uint64_t bits = 0;
+    unsigned int row = 0, column = 0;
+    for (; p < end; p++)
+    {
+        if (*p == '$')
+        {
+            row++;
+            column = 0;
+            continue;
+        }
+        if (row > 7 || column > 7)
+            return Fail("leaf is larger than 8x8");
+        if (*p == '*')
+            bits |= (uint64_t)1 << (row * 8 + column);
+        else if (*p != '.')
+            return Fail("unexpected character in leaf");
+        column++;
+    }
+
+    uint32_t leaf = m_Life.MakeLeaf(bits);
+    if (!leaf)
+        return Fail("pattern doesn't fit in the Hashlife memory limit");
+    m_Levels.push_back((uint8_t)Hashlife::LeafLevel);
+    m_Refs.push_back(leaf);
+    return true;
+}
+
+bool MacrocellDecoder::ParseNode(const char* p, const char* end)
+{
+    uint64_t level = 0;
+    uint64_t children[4];
+    if (!ParseNumber(p, end, level))
+        return Fail("expected a node");
+    for (int i = 0; i < 4; i++)
+        if (!ParseNumber(p, end, children[i]))
+            return Fail("node needs four children");
+    if (level < 1 || level > 62)
+        return Fail("bad level");
+
+    for (int i = 0; i < 4; i++)
+    {
+        if (level == 1)
+        {
+            if (children[i] > 1)
+                return Fail("only two-state cells are supported");
+            continue;
+        }
+        if (children[i] >= m_Refs.size())
+            return Fail("child refers to a later line");
+        if (children[i] && m_Levels[children[i]] != level - 1)
+            return Fail("child is at the wrong level");
+    }
+
+    // Blocks below leaf size are put together in leaf layout
+    if (level < Hashlife::LeafLevel)
+    {
+        uint64_t block = level == 1
+            ? ComposeBlock(children[0], children[1], children[2], children[3], 1)
+            : ComposeBlock(BlockBits(children[0]), BlockBits(children[1]), BlockBits(children[2]), BlockBits(children[3]), 2);
+        m_Levels.push_back((uint8_t)level);
+        m_Refs.push_back((uint32_t)m_Blocks.size());
+        m_Blocks.push_back(block);
+        return true;
+    }
+
+    uint32_t node;
+    if (level == Hashlife::LeafLevel)
+        node = m_Life.MakeLeaf(ComposeBlock(BlockBits(children[0]), BlockBits(children[1]),
+                                            BlockBits(children[2]), BlockBits(children[3]), 4));
+    else
+    {
+        uint32_t refs[4];
+        for (int i = 0; i < 4; i++)
+            refs[i] = children[i] ? m_Refs[children[i]] : m_Life.EmptyNode((unsigned int)level - 1);
+        node = m_Life.MakeNode(refs[0], refs[1], refs[2], refs[3]);
+    }
+    if (!node)
+        return Fail("pattern doesn't fit in the Hashlife memory limit");
+    m_Levels.push_back((uint8_t)level);
+    m_Refs.push_back(node);
+    return true;
+}
+
+bool MacrocellDecoder::Finish()
+{
+    // The last line is the root
+    if (m_Refs.size() < 2)
+        return m_Life.EndLoad(m_Life.EmptyNode(Hashlife::LeafLevel + 1), Hashlife::LeafLevel + 1, m_Generation);
+
+    unsigned int level = m_Levels.back();
+    uint32_t root = m_Refs.back();
+    if (level < Hashlife::LeafLevel)
+    {
+        root = m_Life.MakeLeaf(m_Blocks[root]);
+        level = Hashlife::LeafLevel;
+    }
+    return m_Life.EndLoad(root, level, m_Generation);
+}
+
+bool LoadMacrocell(const std::string& path, Hashlife& life)
+{
+    std::ifstream stream(path, std::ios::binary);
+    if (!stream.is_open())
+    {
+        std::cerr << "Failed to open pattern file: " << path << std::endl;
+        return false;
+    }
+
+    life.BeginLoad();
+    MacrocellDecoder decoder(life);
+
+    // Lines are cut out of fixed size chunks, a partial last line carries over
+    std::vector<char> buffer(ChunkSize);
+    std::size_t carried = 0;
+    bool ok = true;
+    while (ok)
+    {
+        if (carried == buffer.size())
+            buffer.resize(buffer.size() * 2);
+        stream.read(buffer.data() + carried, (std::streamsize)(buffer.size() - carried));
+        std::size_t size = carried + (std::size_t)stream.gcount();
+        bool last = !stream;
+
+        const char* line = buffer.data();
+        const char* end = buffer.data() + size;
+        for (const char* p = line; ok && p < end; p++)
+        {
+            if (*p != '\n')
+                continue;
+            ok = decoder.ParseLine(line, p);
+            line = p + 1;
+        }
+        if (last)
+        {
+            ok = ok && decoder.ParseLine(line, end);
+            break;
+        }
+        carried = (std::size_t)(end - line);
+        std::copy(line, end, buffer.data());
+    }
+
+    if (!ok || !decoder.Finish())
+    {
+        life.EndLoad(0, 0);
+        std::cerr << "Failed to load pattern: " << path << std::endl;
+        return false;
+    }
+    std::cout << "Loaded pattern: " << path << std::endl;
+    return true;
+}
+
+/**
+ * Children are written before their parents and every distinct node once,
+ * numbered in the order written.
+ */
+class MacrocellEncoder
+{
+public:
+    MacrocellEncoder(const Hashlife& life, std::ofstream& stream, SaveProgress* progress)
+        : m_Life(life), m_Stream(stream), m_Progress(progress), m_LineCount(0), m_Flushed(0), m_Done(0.0)
+    {
+        m_Buffer.reserve(ChunkSize + 256);
+    }
+
+    void Text(const std::string& text)
+    {
+        m_Buffer += text;
+    }
+
+    // `share` is the node's part of the whole tree, for progress. Only the
+    // top few levels split it further, below that a subtree counts as one.
+    uint64_t Write(uint32_t node, unsigned int level, double share = 1.0)
+    {
+        if (node == m_Life.EmptyNode(level))
+        {
+            m_Done += share;
+            return 0;
+        }
+        auto it = m_Lines.find(node);
+        if (it != m_Lines.end())
+        {
+            m_Done += share;
+            return it->second;
+        }
+
+        if (level == Hashlife::LeafLevel)
+        {
+            WriteLeaf(m_Life.GetLeafBits(node));
+            m_Done += share;
+        }
+        else
+        {
+            uint32_t children[4];
+            m_Life.GetChildren(node, children);
+            double childShare = share >= MinSplitShare ? share / 4 : 0.0;
+            uint64_t lines[4];
+            for (int i = 0; i < 4; i++)
+                lines[i] = Write(children[i], level - 1, childShare);
+            if (childShare == 0.0)
+                m_Done += share;
+            m_Buffer += std::to_string(level);
+            for (int i = 0; i < 4; i++)
+            {
+                m_Buffer += ' ';
+                m_Buffer += std::to_string(lines[i]);
+            }
+            m_Buffer += '\n';
+        }
+        if (m_Buffer.size() >= ChunkSize)
+            Flush();
+
+        m_Lines.emplace(node, ++m_LineCount);
+        if (m_Progress && (m_LineCount & (ReportLines - 1)) == 0)
+            Report();
+        return m_LineCount;
+    }
+
+    bool Flush()
+    {
+        m_Stream.write(m_Buffer.data(), (std::streamsize)m_Buffer.size());
+        m_Flushed += m_Buffer.size();
+        m_Buffer.clear();
+        if (m_Progress)
+            m_Progress->bytesWritten = m_Flushed;
+        return (bool)m_Stream;
+    }
+
+private:
+    static constexpr double MinSplitShare = 1.0 / 65536;
+    static constexpr uint64_t ReportLines = 1024;
+
+    const Hashlife& m_Life;
+    std::ofstream& m_Stream;
+    SaveProgress* m_Progress;
+    std::string m_Buffer;
+    std::unordered_map<uint32_t, uint64_t> m_Lines;
+    uint64_t m_LineCount;
+    uint64_t m_Flushed;
+    double m_Done;
+
+    void Report()
+    {
+        m_Progress->bytesWritten = m_Flushed + m_Buffer.size();
+        m_Progress->fraction = m_Done;
+        if (m_Progress->pace)
+            m_Progress->pace();
+    }
+
+    // Rows end in '$', trailing dead cells and trailing empty rows are left off
+    void WriteLeaf(uint64_t bits)
+    {
+        for (unsigned int row = 0; row < 8 && (bits >> (row * 8)); row++)
+        {
+            unsigned int cells = (unsigned int)(bits >> (row * 8)) & 0xFF;
+            for (; cells; cells >>= 1)
+                m_Buffer += (cells & 1) ? '*' : '.';
+            m_Buffer += '$';
+        }
+        m_Buffer += '\n';
+    }
+};
+
+bool SaveMacrocell(const std::string& path, const Hashlife& life)
+{
+    return SaveMacrocell(path, life, { life.GetRoot(), life.GetRootLevel(), life.GetGeneration() });
+}
+
+bool SaveMacrocell(const std::string& path, const Hashlife& life, const Hashlife::PinnedRoot& tree,
+                   SaveProgress* progress)
+{
+    std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+    if (!stream.is_open())
+    {
+        std::cerr << "Failed to create pattern file: " << path << std::endl;
+        return false;
+    }
+
+    MacrocellEncoder encoder(life, stream, progress);
+    encoder.Text("[M2] (OpenGLGameOfLife)\n#R B3/S23\n");
+    encoder.Text("#G " + std::to_string(tree.generation) + "\n");
+    // An empty pattern still needs one node for the reader to find
+    if (encoder.Write(tree.root, tree.level) == 0)
+        encoder.Text(std::to_string(tree.level) + " 0 0 0 0\n");
+    if (!encoder.Flush())
+    {
+        std::cerr << "Failed to write pattern file: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
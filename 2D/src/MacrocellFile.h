@@ -0,0 +1,35 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "Hashlife.h"
+
+// Lets another thread follow a save. `pace` runs on the saving thread every
+// thousand or so nodes, e.g. to throttle it.
+struct SaveProgress
+{
+    std::atomic<uint64_t> bytesWritten{ 0 };
+    std::atomic<double> fraction{ 0.0 };
+    std::function<void()> pace;
+};
+
+/**
+ * Macrocell patterns (.mc), Golly's dump of a hash-consed quadtree.
+ *
+ * Every line is one distinct node: an 8x8 leaf drawn with '.', '*' and '$',
+ * or "level nw ne sw se" pointing back at earlier lines, 0 meaning empty.
+ * Loading turns each line straight into an engine node, so memory follows
+ * the number of distinct nodes however wide the pattern is. Saving writes
+ * every distinct node below the given one exactly once.
+ *
+ * A loaded pattern replaces the universe and is centred on the origin. The
+ * second save only reads the given tree, so it can run on another thread
+ * while the engine keeps stepping as long as the tree is pinned.
+ */
+bool LoadMacrocell(const std::string& path, Hashlife& life);
+bool SaveMacrocell(const std::string& path, const Hashlife& life);
+bool SaveMacrocell(const std::string& path, const Hashlife& life, const Hashlife::PinnedRoot& tree,
+                   SaveProgress* progress = nullptr);
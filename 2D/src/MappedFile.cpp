@@ -0,0 +1,183 @@
+#include "MappedFile.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+MappedFile::MappedFile()
+    :m_Data(nullptr), m_Size(0), m_FileDescriptor(-1), m_Writable(false), m_Shared(false)
+{
+}
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+bool MappedFile::Open(const std::string& path, bool writable)
+{
+    Close();
+    int fd = open(path.c_str(), writable ? O_RDWR : O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    void* data = mmap(nullptr, (std::size_t)info.st_size, writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                      MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED)
+    {
+        std::cerr << "Failed to map " << path << ": " << std::strerror(errno) << std::endl;
+        close(fd);
+        return false;
+    }
+
+    m_Data = data;
+    m_Size = (std::size_t)info.st_size;
+    m_FileDescriptor = fd;
+    m_Writable = writable;
+    m_Shared = true;
+    return true;
+}
+
+bool MappedFile::OpenCopyOnWrite(const std::string& path, std::size_t offset)
+{
+    Close();
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (std::size_t)info.st_size <= offset)
+    {
+        close(fd);
+        return false;
+    }
+
+    std::size_t size = (std::size_t)info.st_size - offset;
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, (off_t)offset);
+    if (data == MAP_FAILED)
+    {
+        std::cerr << "Failed to map " << path << ": " << std::strerror(errno) << std::endl;
+        close(fd);
+        return false;
+    }
+
+    m_Data = data;
+    m_Size = size;
+    m_FileDescriptor = fd;
+    m_Writable = true;
+    m_Shared = false;
+    return true;
+}
+
+// Sparse file of the given size, pages only take disk space once written
+bool MappedFile::Create(const std::string& path, std::size_t size)
+{
+    Close();
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        std::cerr << "Failed to create " << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    if (ftruncate(fd, (off_t)size) != 0)
+    {
+        std::cerr << "Failed to size " << path << ": " << std::strerror(errno) << std::endl;
+        close(fd);
+        return false;
+    }
+
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED)
+    {
+        std::cerr << "Failed to map " << path << ": " << std::strerror(errno) << std::endl;
+        close(fd);
+        return false;
+    }
+
+    m_Data = data;
+    m_Size = size;
+    m_FileDescriptor = fd;
+    m_Writable = true;
+    m_Shared = true;
+    return true;
+}
+
+bool MappedFile::CreateAnonymous(std::size_t size)
+{
+    Close();
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (data == MAP_FAILED)
+    {
+        std::cerr << "Failed to reserve " << size << " bytes: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    m_Data = data;
+    m_Size = size;
+    m_Writable = true;
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (m_Data)
+        munmap(m_Data, m_Size);
+    if (m_FileDescriptor >= 0)
+        close(m_FileDescriptor);
+    m_Data = nullptr;
+    m_Size = 0;
+    m_FileDescriptor = -1;
+    m_Writable = false;
+    m_Shared = false;
+}
+
+bool MappedFile::Sync() const
+{
+    if (!m_Data || !m_Shared || !m_Writable)
+        return true;
+    return msync(m_Data, m_Size, MS_SYNC) == 0;
+}
+
+void MappedFile::Zero(std::size_t offset, std::size_t size)
+{
+    char* start = (char*)m_Data + offset;
+    std::size_t page = (std::size_t)sysconf(_SC_PAGESIZE);
+    std::size_t head = std::min(size, (page - offset % page) % page);
+    std::size_t pages = (size - head) / page * page;
+    std::memset(start, 0, head);
+    std::memset(start + head + pages, 0, size - head - pages);
+    if (!pages)
+        return;
+
+    // Dropped anonymous pages read back as zero, shared file pages need a hole
+    // punched. Copy-on-write pages would read back the file, so they get written.
+    bool zeroed = false;
+    if (m_FileDescriptor < 0)
+        zeroed = madvise(start + head, pages, MADV_DONTNEED) == 0;
+    else if (m_Shared)
+        zeroed = fallocate(m_FileDescriptor, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, (off_t)(offset + head), (off_t)pages) == 0;
+    if (!zeroed)
+        std::memset(start + head, 0, pages);
+}
+
+void MappedFile::Swap(MappedFile& other)
+{
+    std::swap(m_Data, other.m_Data);
+    std::swap(m_Size, other.m_Size);
+    std::swap(m_FileDescriptor, other.m_FileDescriptor);
+    std::swap(m_Writable, other.m_Writable);
+    std::swap(m_Shared, other.m_Shared);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+/**
+ * Thin wrapper around mmap. Either maps a file (shared, so writes land in the
+ * file), a file copy-on-write (writes stay in memory and the file is never
+ * touched) or an anonymous region that is only committed as pages get touched.
+ */
+class MappedFile
+{
+private:
+    void* m_Data;
+    std::size_t m_Size;
+    int m_FileDescriptor;
+    bool m_Writable;
+    bool m_Shared;
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const std::string& path, bool writable);
+    // Maps from `offset` (page aligned) to the end of the file
+    bool OpenCopyOnWrite(const std::string& path, std::size_t offset);
+    bool Create(const std::string& path, std::size_t size);
+    bool CreateAnonymous(std::size_t size);
+    void Close();
+
+    bool Sync() const;
+    // Zero-fills a range, whole pages are handed back to the system instead of written
+    void Zero(std::size_t offset, std::size_t size);
+    void Swap(MappedFile& other);
+
+    inline bool IsOpen() const { return m_Data != nullptr; }
+    inline bool IsFile() const { return m_FileDescriptor >= 0; }
+    inline void* GetData() const { return m_Data; }
+    inline std::size_t GetSize() const { return m_Size; }
+};
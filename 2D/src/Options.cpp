@@ -0,0 +1,179 @@
+#include "Options.h"
+#include "PatternFile.h"
+
+#include <cstdlib>
+#include <iostream>
+
+// Accepts plain byte counts or a K/M/G/T suffix, e.g. "8G" or "512M"
+bool ParseByteSize(const std::string& text, std::size_t& bytes)
+{
+    char* end = nullptr;
+    unsigned long long value = std::strtoull(text.c_str(), &end, 10);
+    if (end == text.c_str())
+        return false;
+
+    std::string suffix(end);
+    unsigned int shift = 0;
+    if (suffix.empty() || suffix == "B")
+        shift = 0;
+    else if (suffix == "K" || suffix == "k" || suffix == "KB")
+        shift = 10;
+    else if (suffix == "M" || suffix == "m" || suffix == "MB")
+        shift = 20;
+    else if (suffix == "G" || suffix == "g" || suffix == "GB")
+        shift = 30;
+    else if (suffix == "T" || suffix == "t" || suffix == "TB")
+        shift = 40;
+    else
+        return false;
+
+    bytes = (std::size_t)value << shift;
+    return true;
+}
+
+// Under $XDG_CACHE_HOME, or ~/.cache without it, never the working directory
+static std::string DefaultShaderCache()
+{
+    const char* cache = std::getenv("XDG_CACHE_HOME");
+    if (cache && cache[0] == '/')
+        return std::string(cache) + "/OpenGLGameOfLife/shaders";
+    const char* home = std::getenv("HOME");
+    if (home && home[0] == '/')
+        return std::string(home) + "/.cache/OpenGLGameOfLife/shaders";
+    return "";
+}
+
+bool ParseOptions(int argc, char** argv, Options& options)
+{
+    options.shaderCache = DefaultShaderCache();
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--hashlife-mem" && i + 1 < argc)
+        {
+            if (!ParseByteSize(argv[++i], options.hashlifeMemory))
+            {
+                std::cerr << "Invalid memory size: " << argv[i] << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--threads" && i + 1 < argc)
+        {
+            options.threads = (unsigned int)std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--hashlife-store" && i + 1 < argc)
+        {
+            options.hashlifeStore = argv[++i];
+        }
+        else if (arg == "--pattern" && i + 1 < argc)
+        {
+            options.patternFile = argv[++i];
+        }
+        else if (arg == "--threshold" && i + 1 < argc)
+        {
+            options.imageThreshold = std::strtod(argv[++i], nullptr);
+            if (options.imageThreshold < 0.0 || options.imageThreshold > 1.0)
+            {
+                std::cerr << "Invalid image threshold, it goes from 0 to 1: " << argv[i] << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--verify-snapshot")
+        {
+            options.verifySnapshot = true;
+        }
+        else if (arg == "--save-pattern" && i + 1 < argc)
+        {
+            options.savePatternFile = argv[++i];
+        }
+        else if (arg == "--frame-budget" && i + 1 < argc)
+        {
+            options.frameBudgetMs = std::strtod(argv[++i], nullptr);
+            if (options.frameBudgetMs <= 0.0)
+            {
+                std::cerr << "Invalid frame budget: " << argv[i] << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--max-step" && i + 1 < argc)
+        {
+            options.maxStepLog2 = (unsigned int)std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--checkpoint" && i + 1 < argc)
+        {
+            options.checkpointFile = argv[++i];
+        }
+        else if (arg == "--checkpoint-generations" && i + 1 < argc)
+        {
+            options.checkpointGenerations = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--checkpoint-seconds" && i + 1 < argc)
+        {
+            options.checkpointSeconds = std::strtod(argv[++i], nullptr);
+            if (options.checkpointSeconds < 0.0)
+            {
+                std::cerr << "Invalid checkpoint interval: " << argv[i] << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--history" && i + 1 < argc)
+        {
+            options.historyKeyframes = (unsigned int)std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--history-mem" && i + 1 < argc)
+        {
+            if (!ParseByteSize(argv[++i], options.historyMemory))
+            {
+                std::cerr << "Invalid memory size: " << argv[i] << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--stream" && i + 1 < argc)
+        {
+            options.streamFile = argv[++i];
+        }
+        else if (arg == "--stream-full-every" && i + 1 < argc)
+        {
+            options.streamFullInterval = (unsigned int)std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--upload-buffers" && i + 1 < argc)
+        {
+            options.uploadBuffers = (unsigned int)std::strtoul(argv[++i], nullptr, 10);
+            if (options.uploadBuffers > 3)
+            {
+                std::cerr << "Invalid upload buffer count, it goes from 0 to 3: " << argv[i] << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--shader-dir" && i + 1 < argc)
+        {
+            options.shaderDirectory = argv[++i];
+        }
+        else if (arg == "--shader-cache" && i + 1 < argc)
+        {
+            options.shaderCache = argv[++i];
+        }
+        else if (arg == "--no-shader-cache")
+        {
+            options.shaderCache.clear();
+        }
+        else
+        {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            std::cerr << "Usage: app [--pattern <file>] [--threshold <0-1>] [--verify-snapshot] [--save-pattern <file>] [--hashlife-mem <size>]"
+                      << " [--hashlife-store <file>] [--threads <count>] [--frame-budget <ms>] [--max-step <log2>]"
+                      << " [--checkpoint <file>] [--checkpoint-generations <n>] [--checkpoint-seconds <s>]"
+                      << " [--history <keyframe interval>] [--history-mem <size>]"
+                      << " [--stream <file|->] [--stream-full-every <frames>] [--upload-buffers <0-3>]"
+                      << " [--shader-dir <dir>] [--shader-cache <dir>] [--no-shader-cache]" << std::endl;
+            return false;
+        }
+    }
+    // Only snapshots carry tile checksums
+    if (options.verifySnapshot && PatternExtension(options.patternFile) != "snap")
+    {
+        std::cerr << "--verify-snapshot needs a .snap file as --pattern" << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Command line settings for the app, filled in by ParseOptions.
+struct Options
+{
+    std::size_t hashlifeMemory = (std::size_t)1 << 30;
+    unsigned int threads = 0;     // 0 picks one per hardware thread
+    std::string hashlifeStore;    // node store file, empty keeps nodes in memory only
+    double frameBudgetMs = 12.0;  // simulation time per displayed frame
+    std::string patternFile;      // pattern to start from, .rle, .mc, .snap, .cells, .lif, .pbm or .pgm
+    double imageThreshold = 0.5;  // PGM pixels darker than this (0 to 1) start alive
+    bool verifySnapshot = false;  // check every tile of a .snap pattern before running it
+    std::string savePatternFile;  // where to write the pattern on exit
+    unsigned int maxStepLog2 = 32;  // keeps a long run well inside 64-bit generations
+    std::string checkpointFile;   // Macrocell checkpoint written in the background, empty for none
+    uint64_t checkpointGenerations = 0;  // 0 doesn't checkpoint by generation
+    double checkpointSeconds = 60.0;     // 0 doesn't checkpoint by time
+    unsigned int historyKeyframes = 0;   // rewind history keyframe interval, 0 records no history
+    std::size_t historyMemory = (std::size_t)256 << 20;
+    std::string streamFile;       // binary generation stream, "-" for stdout, empty for none
+    unsigned int streamFullInterval = 600;  // frames between full frames, 0 for only the first
+    unsigned int uploadBuffers = 3;  // segments of the cell upload ring, 0 uploads straight from memory
+    std::string shaderDirectory;  // read shaders from here rather than the built in copies, for editing them
+    std::string shaderCache;      // linked program binaries, ParseOptions puts them under $XDG_CACHE_HOME, empty compiles every run
+};
+
+bool ParseByteSize(const std::string& text, std::size_t& bytes);
+bool ParseOptions(int argc, char** argv, Options& options);
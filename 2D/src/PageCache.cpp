@@ -0,0 +1,146 @@
+#include "PageCache.h"
+
+#include <cstring>
+
+static const std::size_t PageSize = (std::size_t)PageCache::PageWords * PageCache::PageRows;
+
+PageCache::PageCache(unsigned int capacity)
+    : m_Capacity(0), m_Newest(None), m_Oldest(None), m_Frame(0), m_Evictions(0)
+{
+    Reset(capacity);
+}
+
+void PageCache::Reset(unsigned int capacity)
+{
+    m_Capacity = capacity;
+    m_Slots.assign(capacity, Slot());
+    m_Contents.assign((std::size_t)capacity * PageSize, 0);
+    m_Free.clear();
+    for (unsigned int slot = capacity; slot-- > 0;)
+        m_Free.push_back(slot);
+    m_Resident.clear();
+    m_Newest = None;
+    m_Oldest = None;
+    m_Uploads.clear();
+}
+
+bool PageCache::Update(const uint32_t* raster, std::size_t stride, int64_t left, int64_t top, int pagesWide,
+                       int pagesHigh, uint32_t* table)
+{
+    m_Frame++;
+    m_Uploads.clear();
+    bool fits = true;
+    for (int y = 0; y < pagesHigh; y++)
+    {
+        for (int x = 0; x < pagesWide; x++)
+        {
+            const uint32_t* page = raster + (std::size_t)y * PageRows * stride + (std::size_t)x * PageWords;
+            uint32_t& entry = table[(std::size_t)y * pagesWide + x];
+            bool empty = true;
+            for (int row = 0; row < PageRows && empty; row++)
+            {
+                const uint32_t* words = page + (std::size_t)row * stride;
+                for (int word = 0; word < PageWords; word++)
+                    empty = empty && !words[word];
+            }
+
+            Key key = { left + x, top + y };
+            auto it = m_Resident.find(key);
+            if (empty)
+            {
+                // Nothing to draw, the slot is better spent on a page that has cells
+                if (it != m_Resident.end())
+                    Release(it->second);
+                entry = 0;
+                continue;
+            }
+
+            unsigned int slot;
+            bool changed = true;
+            if (it != m_Resident.end())
+            {
+                slot = it->second;
+                Unlink(slot);
+                const uint32_t* cached = m_Contents.data() + (std::size_t)slot * PageSize;
+                changed = false;
+                for (int row = 0; row < PageRows && !changed; row++)
+                    changed = std::memcmp(page + (std::size_t)row * stride, cached + (std::size_t)row * PageWords,
+                                          PageWords * sizeof(uint32_t)) != 0;
+            }
+            else
+            {
+                slot = Acquire();
+                if (slot == None)
+                {
+                    entry = 0;
+                    fits = false;
+                    continue;
+                }
+                m_Slots[slot].key = key;
+                m_Resident.emplace(key, slot);
+            }
+            m_Slots[slot].lastUsed = m_Frame;
+            PushNewest(slot);
+            entry = slot + 1;
+
+            if (changed)
+            {
+                uint32_t* cached = m_Contents.data() + (std::size_t)slot * PageSize;
+                for (int row = 0; row < PageRows; row++)
+                    std::memcpy(cached + (std::size_t)row * PageWords, page + (std::size_t)row * stride,
+                                PageWords * sizeof(uint32_t));
+                m_Uploads.push_back({ slot, x, y });
+            }
+        }
+    }
+    return fits;
+}
+
+void PageCache::Unlink(unsigned int slot)
+{
+    Slot& s = m_Slots[slot];
+    if (s.previous != None)
+        m_Slots[s.previous].next = s.next;
+    else
+        m_Newest = s.next;
+    if (s.next != None)
+        m_Slots[s.next].previous = s.previous;
+    else
+        m_Oldest = s.previous;
+    s.previous = None;
+    s.next = None;
+}
+
+void PageCache::PushNewest(unsigned int slot)
+{
+    Slot& s = m_Slots[slot];
+    s.previous = None;
+    s.next = m_Newest;
+    if (m_Newest != None)
+        m_Slots[m_Newest].previous = slot;
+    m_Newest = slot;
+    if (m_Oldest == None)
+        m_Oldest = slot;
+}
+
+void PageCache::Release(unsigned int slot)
+{
+    Unlink(slot);
+    m_Resident.erase(m_Slots[slot].key);
+    m_Free.push_back(slot);
+}
+
+// A free slot, or the least recently used one unless it is on screen this frame
+unsigned int PageCache::Acquire()
+{
+    if (m_Free.empty())
+    {
+        if (m_Oldest == None || m_Slots[m_Oldest].lastUsed == m_Frame)
+            return None;
+        Release(m_Oldest);
+        m_Evictions++;
+    }
+    unsigned int slot = m_Free.back();
+    m_Free.pop_back();
+    return slot;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Bookkeeping for a virtual cell texture: which page of the universe sits in
+ * which slot of a fixed-size physical page texture.
+ *
+ * A page is PageWords x PageRows texels of the bit raster (512 x 64 cells)
+ * at a fixed place in the universe, so a page stays valid however the view
+ * moves. Every frame the view's pages are looked up: an empty page needs no
+ * slot at all, a resident page whose cells didn't change needs nothing, and
+ * the rest get a slot (the least recently used one when none is free) and go
+ * on the upload list. A copy of every resident page is kept to tell what
+ * changed, so panning only sends the pages that came into view and a running
+ * pattern only the pages it touched.
+ *
+ * There are no GL calls in here, the renderer does the uploads.
+ */
+class PageCache
+{
+public:
+    static constexpr int PageWords = 16;
+    static constexpr int PageRows = 64;
+    static constexpr int PageCells = PageWords * 32;
+
+    struct Upload
+    {
+        unsigned int slot;
+        int x, y;            // page in the raster
+    };
+
+    PageCache(unsigned int capacity = 0);
+
+    // Drops every page, e.g. when the page texture was lost or reallocated
+    void Reset(unsigned int capacity);
+    unsigned int GetCapacity() const { return m_Capacity; }
+
+    // Looks up the pages of a raster that starts at page (left, top) and is
+    // pagesWide x pagesHigh pages, rows `stride` words apart. Fills `table`
+    // (one entry per page, slot + 1 or 0 for empty) and the upload list.
+    // False if more pages are visible than there are slots, the ones that
+    // didn't fit show as empty.
+    bool Update(const uint32_t* raster, std::size_t stride, int64_t left, int64_t top, int pagesWide, int pagesHigh,
+                uint32_t* table);
+
+    const std::vector<Upload>& GetUploads() const { return m_Uploads; }
+    uint64_t GetEvictions() const { return m_Evictions; }
+    std::size_t GetResidentCount() const { return m_Resident.size(); }
+
+private:
+    struct Key
+    {
+        int64_t x, y;
+        bool operator==(const Key& other) const { return x == other.x && y == other.y; }
+    };
+
+    struct KeyHash
+    {
+        std::size_t operator()(const Key& key) const
+        {
+            uint64_t h = (uint64_t)key.x * 0x9E3779B97F4A7C15ull ^ (uint64_t)key.y * 0xC2B2AE3D27D4EB4Full;
+            return (std::size_t)(h ^ (h >> 29));
+        }
+    };
+
+    // Slots in use form a list from most to least recently used
+    struct Slot
+    {
+        Key key;
+        uint64_t lastUsed = 0;
+        unsigned int previous = None;
+        unsigned int next = None;
+    };
+
+    static constexpr unsigned int None = ~0u;
+
+    unsigned int m_Capacity;
+    std::vector<Slot> m_Slots;
+    std::vector<uint32_t> m_Contents;     // PageWords x PageRows words per slot
+    std::vector<unsigned int> m_Free;
+    std::unordered_map<Key, unsigned int, KeyHash> m_Resident;
+    unsigned int m_Newest;
+    unsigned int m_Oldest;
+    uint64_t m_Frame;
+    uint64_t m_Evictions;
+    std::vector<Upload> m_Uploads;
+
+    void Unlink(unsigned int slot);
+    void PushNewest(unsigned int slot);
+    void Release(unsigned int slot);
+    unsigned int Acquire();
+};
@@ -0,0 +1,158 @@
+#include "PatternBuilder.h"
+#include "Hashlife.h"
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <utility>
+
+// Roots can't go past this level, see Hashlife::ExpandRoot
+static const unsigned int MaxRootLevel = 62;
+
+PatternBuilder::PatternBuilder(Hashlife& life)
+    : m_Life(life), m_LastBand(-1), m_RootLevel(0), m_Failed(false)
+{
+    m_Life.BeginLoad();
+}
+
+bool PatternBuilder::AddBand(int64_t band, const std::vector<PatternLeaf>& leaves, const uint32_t* nodes)
+{
+    if (m_Failed)
+        return false;
+    if (band <= m_LastBand)
+    {
+        std::cerr << "PatternBuilder: band " << band << " is out of order" << std::endl;
+        m_Failed = true;
+        return false;
+    }
+    m_LastBand = band;
+
+    std::vector<Entry> entries;
+    entries.reserve(leaves.size());
+    for (std::size_t i = 0; i < leaves.size(); i++)
+    {
+        const PatternLeaf& leaf = leaves[i];
+        if (!leaf.bits)
+            continue;
+        if (leaf.column < 0)
+        {
+            std::cerr << "PatternBuilder: column " << leaf.column << " is left of the pattern" << std::endl;
+            m_Failed = true;
+            return false;
+        }
+        uint32_t node = nodes ? nodes[i] : m_Life.MakeLeaf(leaf.bits);
+        if (!node)
+        {
+            std::cerr << "PatternBuilder: pattern doesn't fit in the Hashlife memory limit" << std::endl;
+            m_Failed = true;
+            return false;
+        }
+        entries.push_back({ leaf.column, node });
+    }
+    return Push(0, band, entries);
+}
+
+bool PatternBuilder::Finish(uint64_t generation)
+{
+    // Whatever is still waiting gets paired with empty space on the way up
+    // until a single node covers everything from the origin.
+    for (unsigned int depth = 0; !m_Failed && depth < m_Pending.size(); depth++)
+    {
+        if (!m_Pending[depth].used)
+            continue;
+
+        bool above = false;
+        for (unsigned int d = depth + 1; d < m_Pending.size(); d++)
+            above = above || m_Pending[d].used;
+
+        Row row = std::move(m_Pending[depth]);
+        m_Pending[depth] = Row();
+        if (!above && row.y == 0 && row.entries.size() == 1 && row.entries[0].column == 0
+            && Hashlife::LeafLevel + depth >= m_RootLevel)
+            return m_Life.EndLoad(row.entries[0].node, Hashlife::LeafLevel + depth, generation);
+
+        std::vector<Entry> parents;
+        if (!Combine(depth, row.entries, std::vector<Entry>(), parents) || !Push(depth + 1, row.y >> 1, parents))
+            m_Failed = true;
+    }
+
+    if (m_Failed)
+    {
+        m_Life.EndLoad(0, 0);
+        return false;
+    }
+    return m_Life.EndLoad(m_Life.EmptyNode(Hashlife::LeafLevel + 1), Hashlife::LeafLevel + 1, generation);
+}
+
+bool PatternBuilder::Push(unsigned int depth, int64_t y, std::vector<Entry>& entries)
+{
+    if (entries.empty())
+        return true;
+    if (Hashlife::LeafLevel + depth > MaxRootLevel)
+    {
+        std::cerr << "PatternBuilder: pattern is too large" << std::endl;
+        m_Failed = true;
+        return false;
+    }
+    if (m_Pending.size() <= depth)
+        m_Pending.resize(depth + 1);
+
+    // Only even rows wait, an odd row either completes them or goes up alone
+    std::vector<Entry> parents;
+    if (m_Pending[depth].used)
+    {
+        Row row = std::move(m_Pending[depth]);
+        m_Pending[depth] = Row();
+        if (y == row.y + 1)
+        {
+            if (!Combine(depth, row.entries, entries, parents))
+                return false;
+            return Push(depth + 1, y >> 1, parents);
+        }
+        if (!Combine(depth, row.entries, std::vector<Entry>(), parents) || !Push(depth + 1, row.y >> 1, parents))
+            return false;
+        parents.clear();
+    }
+
+    if ((y & 1) == 0)
+    {
+        Row& row = m_Pending[depth];
+        row.y = y;
+        row.used = true;
+        row.entries.swap(entries);
+        return true;
+    }
+    if (!Combine(depth, std::vector<Entry>(), entries, parents))
+        return false;
+    return Push(depth + 1, y >> 1, parents);
+}
+
+bool PatternBuilder::Combine(unsigned int depth, const std::vector<Entry>& top, const std::vector<Entry>& bottom,
+                             std::vector<Entry>& parents)
+{
+    const int64_t none = std::numeric_limits<int64_t>::max();
+    uint32_t e = m_Life.EmptyNode(Hashlife::LeafLevel + depth);
+    parents.reserve(std::max(top.size(), bottom.size()));
+
+    std::size_t i = 0, j = 0;
+    while (i < top.size() || j < bottom.size())
+    {
+        int64_t column = std::min(i < top.size() ? top[i].column >> 1 : none,
+                                  j < bottom.size() ? bottom[j].column >> 1 : none);
+        uint32_t quadrants[4] = { e, e, e, e };
+        for (; i < top.size() && top[i].column >> 1 == column; i++)
+            quadrants[top[i].column & 1] = top[i].node;
+        for (; j < bottom.size() && bottom[j].column >> 1 == column; j++)
+            quadrants[2 + (bottom[j].column & 1)] = bottom[j].node;
+
+        uint32_t node = m_Life.MakeNode(quadrants[0], quadrants[1], quadrants[2], quadrants[3]);
+        if (!node)
+        {
+            std::cerr << "PatternBuilder: pattern doesn't fit in the Hashlife memory limit" << std::endl;
+            m_Failed = true;
+            return false;
+        }
+        parents.push_back({ column, node });
+    }
+    return true;
+}
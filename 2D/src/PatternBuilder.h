@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+class Hashlife;
+
+// One 8x8 leaf of a band, `column` is the leaf's x in units of 8 cells
+struct PatternLeaf
+{
+    int64_t column;
+    uint64_t bits;
+};
+
+/**
+ * Builds a Hashlife tree bottom-up from bands of leaves.
+ *
+ * Loaders hand over one band (8 rows of cells) at a time, top to bottom, with
+ * its leaves sorted by column. Two bands of leaves pair up into a row of level
+ * 4 nodes, two of those into a row of level 5 nodes and so on, so only one
+ * pending row per level is ever held and no dense grid is built. Coordinates
+ * start at 0 in the top left corner of the pattern and can't be negative.
+ */
+class PatternBuilder
+{
+public:
+    PatternBuilder(Hashlife& life);
+
+    // The root is normally just big enough for the pattern. Fixing its level
+    // fixes where the pattern lands: (0, 0) becomes the top left corner of
+    // the level `level` square centred on the origin.
+    void SetRootLevel(unsigned int level) { m_RootLevel = level; }
+
+    // `band` is the band's y in units of 8 rows, higher than any band before it.
+    // `nodes`, if given, holds the leaves already made with MakeLeaf (loaders
+    // make them on several threads), one per leaf.
+    bool AddBand(int64_t band, const std::vector<PatternLeaf>& leaves, const uint32_t* nodes = nullptr);
+    // Builds the root and makes it the engine's pattern, false if it didn't fit
+    bool Finish(uint64_t generation = 0);
+
+private:
+    struct Entry
+    {
+        int64_t column;
+        uint32_t node;
+    };
+
+    struct Row
+    {
+        int64_t y = 0;
+        bool used = false;
+        std::vector<Entry> entries;
+    };
+
+    Hashlife& m_Life;
+    std::vector<Row> m_Pending;      // per level above the leaves, a top half waiting for its bottom
+    int64_t m_LastBand;
+    unsigned int m_RootLevel;
+    bool m_Failed;
+
+    bool Push(unsigned int depth, int64_t y, std::vector<Entry>& entries);
+    bool Combine(unsigned int depth, const std::vector<Entry>& top, const std::vector<Entry>& bottom,
+                 std::vector<Entry>& parents);
+};
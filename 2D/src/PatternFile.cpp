@@ -0,0 +1,54 @@
+#include "PatternFile.h"
+#include "CellsFile.h"
+#include "ImageFile.h"
+#include "Life106File.h"
+#include "MacrocellFile.h"
+#include "RleFile.h"
+#include "SnapshotFile.h"
+
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+
+std::string PatternExtension(const std::string& path)
+{
+    std::size_t dot = path.find_last_of('.');
+    std::size_t slash = path.find_last_of("/\\");
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+        return "";
+    std::string extension = path.substr(dot + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return (char)std::tolower(c); });
+    return extension;
+}
+
+bool LoadPattern(const std::string& path, Hashlife& life, double imageThreshold)
+{
+    std::string extension = PatternExtension(path);
+    if (extension == "mc")
+        return LoadMacrocell(path, life);
+    if (extension == "snap")
+        return LoadSnapshot(path, life);
+    if (extension == "cells")
+        return LoadCells(path, life);
+    if (extension == "lif" || extension == "life")
+        return LoadLife106(path, life);
+    if (extension == "pbm" || extension == "pgm")
+        return LoadImage(path, life, imageThreshold);
+    return LoadRle(path, life);
+}
+
+bool SavePattern(const std::string& path, Hashlife& life)
+{
+    std::string extension = PatternExtension(path);
+    if (extension == "mc")
+        return SaveMacrocell(path, life);
+    if (extension == "snap")
+        return SaveSnapshot(path, life);
+    if (extension == "cells" || extension == "lif" || extension == "life" || extension == "pbm" || extension == "pgm")
+    {
+        std::cerr << "Saving ." << extension << " isn't supported, use .rle, .mc or .snap" << std::endl;
+        return false;
+    }
+    return SaveRle(path, life);
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <string>
+
+class Hashlife;
+
+// Picks the pattern format from the file extension: .mc is Macrocell, .snap
+// is a binary snapshot, .cells plaintext, .lif/.life Life 1.06 and .pbm/.pgm
+// images (load only, `imageThreshold` is for PGM), anything else is RLE.
+// Saving a snapshot collects garbage first, so the engine isn't const.
+bool LoadPattern(const std::string& path, Hashlife& life, double imageThreshold = 0.5);
+bool SavePattern(const std::string& path, Hashlife& life);
+// Lowercased, without the dot, empty if there is none
+std::string PatternExtension(const std::string& path);
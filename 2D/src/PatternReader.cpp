@@ -0,0 +1,155 @@
+#include "PatternReader.h"
+#include "Hashlife.h"
+
+#include <algorithm>
+
+static const uint64_t NoCells = ~0ull;
+
+PatternReader::PatternReader(const Hashlife& life)
+    : m_Life(life)
+{
+}
+
+PatternReader::Box PatternReader::NodeBounds(uint32_t node, unsigned int level)
+{
+    if (node == m_Life.EmptyNode(level))
+        return { NoCells, NoCells, 0, 0 };
+
+    if (level == Hashlife::LeafLevel)
+    {
+        uint64_t bits = m_Life.GetLeafBits(node);
+        uint64_t columns = bits;
+        columns |= columns >> 32;
+        columns |= columns >> 16;
+        columns |= columns >> 8;
+        columns &= 0xFF;
+        return { (uint64_t)__builtin_ctzll(columns), (uint64_t)__builtin_ctzll(bits) / 8,
+                 (uint64_t)(64 - __builtin_clzll(columns)), (uint64_t)(71 - __builtin_clzll(bits)) / 8 };
+    }
+
+    auto it = m_Boxes.find(node);
+    if (it != m_Boxes.end())
+        return it->second;
+
+    uint32_t children[4];
+    m_Life.GetChildren(node, children);
+    uint64_t half = (uint64_t)1 << (level - 1);
+    Box box = { NoCells, NoCells, 0, 0 };
+    for (int i = 0; i < 4; i++)
+    {
+        Box child = NodeBounds(children[i], level - 1);
+        if (child.left == NoCells)
+            continue;
+        uint64_t x = (i & 1) ? half : 0;
+        uint64_t y = (i & 2) ? half : 0;
+        box.left = std::min(box.left, child.left + x);
+        box.top = std::min(box.top, child.top + y);
+        box.right = std::max(box.right, child.right + x);
+        box.bottom = std::max(box.bottom, child.bottom + y);
+    }
+    m_Boxes.emplace(node, box);
+    return box;
+}
+
+bool PatternReader::GetBounds(int64_t& left, int64_t& top, int64_t& right, int64_t& bottom)
+{
+    unsigned int level = m_Life.GetRootLevel();
+    Box box = NodeBounds(m_Life.GetRoot(), level);
+    if (box.left == NoCells)
+        return false;
+
+    int64_t origin = -((int64_t)1 << (level - 1));
+    left = origin + (int64_t)box.left;
+    top = origin + (int64_t)box.top;
+    right = origin + (int64_t)box.right;
+    bottom = origin + (int64_t)box.bottom;
+    return true;
+}
+
+bool PatternReader::ForEachBand(const std::function<bool(int64_t, const std::vector<PatternLeaf>&)>& visit) const
+{
+    unsigned int level = m_Life.GetRootLevel();
+    uint32_t root = m_Life.GetRoot();
+    if (root == m_Life.EmptyNode(level))
+        return true;
+    std::vector<Entry> row = { { 0, root } };
+    return VisitRow(row, level, 0, visit);
+}
+
+/**
+ * A row of same-level nodes splits into a top row of their northern children
+ * and a bottom row of their southern ones, depth first so bands come out in
+ * order. Only one row per level is alive at a time.
+ */
+bool PatternReader::VisitRow(const std::vector<Entry>& row, unsigned int level, int64_t y,
+                             const std::function<bool(int64_t, const std::vector<PatternLeaf>&)>& visit) const
+{
+    if (level == Hashlife::LeafLevel)
+    {
+        int64_t origin = -((int64_t)1 << (m_Life.GetRootLevel() - 4));
+        std::vector<PatternLeaf> leaves;
+        leaves.reserve(row.size());
+        for (const Entry& entry : row)
+            leaves.push_back({ origin + entry.column, m_Life.GetLeafBits(entry.node) });
+        return visit(origin + y, leaves);
+    }
+
+    uint32_t e = m_Life.EmptyNode(level - 1);
+    std::vector<Entry> top;
+    std::vector<Entry> bottom;
+    for (const Entry& entry : row)
+    {
+        uint32_t children[4];
+        m_Life.GetChildren(entry.node, children);
+        if (children[0] != e)
+            top.push_back({ entry.column * 2, children[0] });
+        if (children[1] != e)
+            top.push_back({ entry.column * 2 + 1, children[1] });
+        if (children[2] != e)
+            bottom.push_back({ entry.column * 2, children[2] });
+        if (children[3] != e)
+            bottom.push_back({ entry.column * 2 + 1, children[3] });
+    }
+
+    if (!top.empty() && !VisitRow(top, level - 1, y * 2, visit))
+        return false;
+    if (!bottom.empty() && !VisitRow(bottom, level - 1, y * 2 + 1, visit))
+        return false;
+    return true;
+}
+
+void PatternReader::ReadRegion(int64_t left, int64_t top, uint64_t width, uint64_t height, uint8_t* raster,
+                               std::size_t stride) const
+{
+    unsigned int level = m_Life.GetRootLevel();
+    int64_t origin = -((int64_t)1 << (level - 1));
+    Region region = { left, top, left + (int64_t)width, top + (int64_t)height, raster, stride };
+    ReadNode(m_Life.GetRoot(), level, origin, origin, region);
+}
+
+void PatternReader::ReadNode(uint32_t node, unsigned int level, int64_t x, int64_t y, const Region& region) const
+{
+    int64_t size = (int64_t)1 << level;
+    if (x >= region.right || y >= region.bottom || x + size <= region.left || y + size <= region.top
+        || node == m_Life.EmptyNode(level))
+        return;
+
+    if (level == Hashlife::LeafLevel)
+    {
+        uint64_t bits = m_Life.GetLeafBits(node);
+        uint8_t* column = region.raster + (x - region.left) / 8;
+        for (int64_t r = 0; r < 8; r++)
+        {
+            int64_t row = y + r - region.top;
+            if (row >= 0 && row < region.bottom - region.top)
+                column[row * (int64_t)region.stride] = (uint8_t)(bits >> (r * 8));
+        }
+        return;
+    }
+
+    uint32_t children[4];
+    m_Life.GetChildren(node, children);
+    int64_t half = size / 2;
+    for (int i = 0; i < 4; i++)
+        ReadNode(children[i], level - 1, x + ((i & 1) ? half : 0), y + ((i & 2) ? half : 0), region);
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+#include "PatternBuilder.h"
+
+class Hashlife;
+
+/**
+ * Walks the engine's current pattern in reading order for pattern writers.
+ *
+ * Bands of 8 rows come out top to bottom with their leaves sorted by column,
+ * the mirror image of PatternBuilder. Empty quadrants are skipped on the way
+ * down, so the cost follows the number of live leaves rather than the size
+ * of the universe. Columns and bands are in engine coordinates divided by 8.
+ */
+class PatternReader
+{
+public:
+    PatternReader(const Hashlife& life);
+
+    // Bounding box of the live cells, right and bottom exclusive. False if empty.
+    bool GetBounds(int64_t& left, int64_t& top, int64_t& right, int64_t& bottom);
+
+    // Stops early and returns false when `visit` does
+    bool ForEachBand(const std::function<bool(int64_t band, const std::vector<PatternLeaf>& leaves)>& visit) const;
+
+    // Live cells of the width x height rectangle at (left, top) as a bit
+    // raster: cell (left + x, top + y) is bit x % 8 of byte x / 8 of row y,
+    // rows `stride` bytes apart. `left` has to be a multiple of 8 so leaf rows
+    // land on whole bytes. Only bytes under live leaves are written, so the
+    // raster has to start out clear. Quadrants outside the rectangle are
+    // never visited.
+    void ReadRegion(int64_t left, int64_t top, uint64_t width, uint64_t height, uint8_t* raster,
+                    std::size_t stride) const;
+
+private:
+    struct Box
+    {
+        uint64_t left, top, right, bottom;
+    };
+
+    struct Entry
+    {
+        int64_t column;
+        uint32_t node;
+    };
+
+    struct Region
+    {
+        int64_t left, top, right, bottom;
+        uint8_t* raster;
+        std::size_t stride;
+    };
+
+    const Hashlife& m_Life;
+    std::unordered_map<uint32_t, Box> m_Boxes;   // per node, relative to its own corner
+
+    Box NodeBounds(uint32_t node, unsigned int level);
+    bool VisitRow(const std::vector<Entry>& row, unsigned int level, int64_t y,
+                  const std::function<bool(int64_t, const std::vector<PatternLeaf>&)>& visit) const;
+    void ReadNode(uint32_t node, unsigned int level, int64_t x, int64_t y, const Region& region) const;
+};
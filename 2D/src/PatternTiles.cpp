@@ -0,0 +1,100 @@
+#include "PatternTiles.h"
+#include "Hashlife.h"
+#include "PatternBuilder.h"
+#include "PatternReader.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+void CaptureTiles(const Hashlife& life, std::vector<PatternTile>& tiles)
+{
+    tiles.clear();
+    PatternReader reader(life);
+    reader.ForEachBand([&](int64_t band, const std::vector<PatternLeaf>& leaves)
+    {
+        for (const PatternLeaf& leaf : leaves)
+            tiles.push_back({ leaf.column, band, leaf.bits });
+        return true;
+    });
+}
+
+// Merges two sorted lists, tiles in both are combined with `op` and dropped if that leaves them empty
+template <typename Op>
+static void MergeTiles(const std::vector<PatternTile>& a, const std::vector<PatternTile>& b,
+                       std::vector<PatternTile>& result, Op op)
+{
+    result.clear();
+    auto before = [](const PatternTile& x, const PatternTile& y) { return x.band < y.band || (x.band == y.band && x.column < y.column); };
+    std::size_t i = 0, j = 0;
+    while (i < a.size() || j < b.size())
+    {
+        if (j == b.size() || (i < a.size() && before(a[i], b[j])))
+            result.push_back(a[i++]);
+        else if (i == a.size() || before(b[j], a[i]))
+            result.push_back(b[j++]);
+        else
+        {
+            uint64_t bits = op(a[i].bits, b[j].bits);
+            if (bits)
+                result.push_back({ a[i].column, a[i].band, bits });
+            i++;
+            j++;
+        }
+    }
+}
+
+void XorTiles(const std::vector<PatternTile>& a, const std::vector<PatternTile>& b, std::vector<PatternTile>& result)
+{
+    MergeTiles(a, b, result, [](uint64_t x, uint64_t y) { return x ^ y; });
+}
+
+void OrTiles(const std::vector<PatternTile>& a, const std::vector<PatternTile>& b, std::vector<PatternTile>& result)
+{
+    MergeTiles(a, b, result, [](uint64_t x, uint64_t y) { return x | y; });
+}
+
+bool BuildTiles(const std::vector<PatternTile>& tiles, uint64_t generation, Hashlife& life, ThreadPool* pool)
+{
+    // Smallest centred square that holds every tile, its top left corner is
+    // the builder's origin so the cells land where the tiles say
+    int64_t extent = 1;
+    for (const PatternTile& tile : tiles)
+        extent = std::max({ extent, -tile.band, tile.band + 1, -tile.column, tile.column + 1 });
+    unsigned int level = Hashlife::LeafLevel + 1;
+    while (((int64_t)1 << (level - Hashlife::LeafLevel - 1)) < extent)
+        level++;
+    int64_t offset = (int64_t)1 << (level - Hashlife::LeafLevel - 1);
+
+    PatternBuilder builder(life);
+    builder.SetRootLevel(level);
+
+    // Leaves can be made up front on every thread, the builder has cleared the engine by now
+    std::vector<uint32_t> nodes;
+    if (pool)
+    {
+        const std::size_t batch = 1 << 16;
+        nodes.resize(tiles.size());
+        pool->Run((unsigned int)((tiles.size() + batch - 1) / batch), [&](unsigned int b)
+        {
+            std::size_t end = std::min(tiles.size(), (b + 1) * batch);
+            for (std::size_t i = b * batch; i < end; i++)
+                nodes[i] = life.MakeLeaf(tiles[i].bits);
+        });
+    }
+
+    std::vector<PatternLeaf> leaves;
+    for (std::size_t i = 0; i < tiles.size();)
+    {
+        int64_t band = tiles[i].band;
+        std::size_t first = i;
+        leaves.clear();
+        for (; i < tiles.size() && tiles[i].band == band; i++)
+            leaves.push_back({ tiles[i].column + offset, tiles[i].bits });
+        if (!builder.AddBand(band + offset, leaves, pool ? nodes.data() + first : nullptr))
+        {
+            builder.Finish();
+            return false;
+        }
+    }
+    return builder.Finish(generation);
+}
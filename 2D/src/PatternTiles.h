@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+class Hashlife;
+class ThreadPool;
+
+// One live 8x8 leaf at its place in the universe, positions in units of 8
+// cells. Lists are kept sorted by band, then column.
+struct PatternTile
+{
+    int64_t column;
+    int64_t band;
+    uint64_t bits;
+};
+
+// Every non-empty leaf of the current pattern, reusing the list's storage
+void CaptureTiles(const Hashlife& life, std::vector<PatternTile>& tiles);
+// Tiles that differ between `a` and `b`, XORed. Also turns a and a delta into b.
+void XorTiles(const std::vector<PatternTile>& a, const std::vector<PatternTile>& b, std::vector<PatternTile>& result);
+// Union of `a` and `b`
+void OrTiles(const std::vector<PatternTile>& a, const std::vector<PatternTile>& b, std::vector<PatternTile>& result);
+// Replaces the universe with the tiles, each one exactly where it says. With
+// a pool the leaves are made on all of its threads.
+bool BuildTiles(const std::vector<PatternTile>& tiles, uint64_t generation, Hashlife& life, ThreadPool* pool = nullptr);
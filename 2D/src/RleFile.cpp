@@ -0,0 +1,326 @@
+#include "RleFile.h"
+#include "ChunkedLoader.h"
+#include "Hashlife.h"
+#include "MappedFile.h"
+#include "PatternReader.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+static const std::size_t ChunkSize = 1 << 20;
+static const std::size_t MaxLineLength = 70;
+
+// Strips spaces and lowercases so "B3/S23" and "b3/s23 " compare equal
+static std::string NormaliseRule(const std::string& rule)
+{
+    std::string result;
+    for (char c : rule)
+        if (!std::isspace((unsigned char)c))
+            result += (char)std::tolower((unsigned char)c);
+    return result;
+}
+
+// "x = 36, y = 9, rule = B3/S23", every field optional
+static void ParseHeader(const std::string& header, int64_t& width, int64_t& height)
+{
+    std::size_t start = 0;
+    while (start < header.size())
+    {
+        std::size_t comma = header.find(',', start);
+        if (comma == std::string::npos)
+            comma = header.size();
+        std::string field = header.substr(start, comma - start);
+        start = comma + 1;
+
+        std::size_t equals = field.find('=');
+        if (equals == std::string::npos)
+            continue;
+        std::string key = NormaliseRule(field.substr(0, equals));
+        std::string value = field.substr(equals + 1);
+        if (key == "x")
+            width = std::strtoll(value.c_str(), nullptr, 10);
+        else if (key == "y")
+            height = std::strtoll(value.c_str(), nullptr, 10);
+        else if (key == "rule")
+        {
+            std::string rule = NormaliseRule(value);
+            if (rule != "b3/s23" && rule != "23/3")
+                std::cerr << "RLE: rule " << value << " isn't supported, running it as B3/S23" << std::endl;
+        }
+    }
+}
+
+// Golly's "#CXRLE Pos=-3,-1 Gen=123": where the top left cell goes and the generation
+static void ParseComment(const std::string& comment, bool& positioned, int64_t& x, int64_t& y, uint64_t& generation)
+{
+    if (comment.compare(0, 6, "#CXRLE") != 0)
+        return;
+    std::size_t pos = comment.find("Pos=");
+    if (pos != std::string::npos)
+    {
+        char* end = nullptr;
+        x = std::strtoll(comment.c_str() + pos + 4, &end, 10);
+        positioned = *end == ',';
+        if (positioned)
+            y = std::strtoll(end + 1, nullptr, 10);
+    }
+    std::size_t gen = comment.find("Gen=");
+    if (gen != std::string::npos)
+        generation = std::strtoull(comment.c_str() + gen + 4, nullptr, 10);
+}
+
+// First pass, only the '$' counts matter
+static void CountRows(TextChunk& chunk)
+{
+    uint64_t count = 0;
+    for (const char* p = chunk.begin; p < chunk.end; p++)
+    {
+        char c = *p;
+        if (c >= '0' && c <= '9')
+        {
+            count = count * 10 + (uint64_t)(c - '0');
+            continue;
+        }
+        if (c == '$')
+            chunk.rows += count ? count : 1;
+        else if (c == '!')
+        {
+            chunk.end = p;
+            chunk.last = true;
+            return;
+        }
+        else if (c == '\n' || c == '\r' || c == ' ' || c == '\t' || (c >= 'p' && c <= 'y'))
+            continue;
+        count = 0;
+    }
+}
+
+static void Decode(const TextChunk& chunk, BandCollector& collector)
+{
+    // The hot loop
+    int64_t x = collector.GetLeft();
+    uint64_t count = 0;
+    for (const char* p = chunk.begin; p < chunk.end; p++)
+    {
+        char c = *p;
+        if (c >= '0' && c <= '9')
+        {
+            count = count * 10 + (uint64_t)(c - '0');
+            continue;
+        }
+        if (c == '\n' || c == '\r' || c == ' ' || c == '\t')
+            continue;
+        uint64_t run = count ? count : 1;
+        if (c == 'b' || c == '.')
+            x += (int64_t)run;
+        else if (c == 'o' || (c >= 'A' && c <= 'X'))
+        {
+            collector.AddRun(x, run);
+            x += (int64_t)run;
+        }
+        else if (c == '$')
+        {
+            collector.EndRows(run);
+            x = collector.GetLeft();
+        }
+        else if (c >= 'p' && c <= 'y')
+        {
+            // Prefix of a multi-state cell, the letter after it carries the count
+            continue;
+        }
+        count = 0;
+    }
+}
+
+bool LoadRle(const std::string& path, Hashlife& life)
+{
+    auto start = std::chrono::steady_clock::now();
+    MappedFile file;
+    if (!file.Open(path, false))
+    {
+        std::cerr << "Failed to open pattern file: " << path << std::endl;
+        return false;
+    }
+
+    // Comment and header lines come first, the runs start at the first other line
+    const char* p = (const char*)file.GetData();
+    const char* end = p + file.GetSize();
+    int64_t width = 0, height = 0, x = 0, y = 0;
+    bool positioned = false;
+    uint64_t generation = 0;
+    while (p < end)
+    {
+        if (std::isspace((unsigned char)*p))
+        {
+            p++;
+            continue;
+        }
+        if (*p != '#' && *p != 'x')
+            break;
+        const char* line = p;
+        p = (const char*)std::memchr(line, '\n', (std::size_t)(end - line));
+        if (!p)
+            p = end;
+        if (*line == 'x')
+            ParseHeader(std::string(line, p), width, height);
+        else
+            ParseComment(std::string(line, p), positioned, x, y, generation);
+    }
+
+    // A pattern saved with its position goes back there, anything else is centred
+    int64_t left = 0, top = 0;
+    unsigned int rootLevel = 0;
+    if (!positioned || !PlaceOffsets(x, y, width, height, left, top, rootLevel))
+        CentreOffsets(width, height, left, top);
+    ThreadPool pool(life.GetThreadCount());
+    std::vector<TextChunk> chunks = SplitText(p, (std::size_t)(end - p), '$');
+    if (!LoadChunks(life, pool, chunks, left, top, CountRows, Decode, generation, rootLevel))
+    {
+        std::cerr << "Failed to load pattern: " << path << std::endl;
+        return false;
+    }
+
+    auto finish = std::chrono::steady_clock::now();
+    std::cout << "Loaded pattern: " << path << " in "
+              << std::chrono::duration<double, std::milli>(finish - start).count() << " ms on "
+              << pool.GetThreadCount() << " threads" << std::endl;
+    return true;
+}
+
+/**
+ * Output side, buffers a chunk of text at a time and wraps lines at 70
+ * characters like every other RLE writer.
+ */
+class RleEncoder
+{
+public:
+    RleEncoder(std::ofstream& stream)
+        : m_Stream(stream), m_LineLength(0)
+    {
+        m_Buffer.reserve(ChunkSize + 64);
+    }
+
+    void Text(const std::string& text)
+    {
+        m_Buffer += text;
+    }
+
+    void Run(uint64_t count, char tag)
+    {
+        char item[24];
+        int length = 0;
+        if (count > 1)
+        {
+            char digits[20];
+            int n = 0;
+            for (; count; count /= 10)
+                digits[n++] = (char)('0' + count % 10);
+            while (n)
+                item[length++] = digits[--n];
+        }
+        item[length++] = tag;
+
+        if (m_LineLength + length > MaxLineLength)
+        {
+            m_Buffer += '\n';
+            m_LineLength = 0;
+        }
+        m_Buffer.append(item, length);
+        m_LineLength += length;
+        if (m_Buffer.size() >= ChunkSize)
+            Flush();
+    }
+
+    bool Flush()
+    {
+        m_Stream.write(m_Buffer.data(), (std::streamsize)m_Buffer.size());
+        m_Buffer.clear();
+        return (bool)m_Stream;
+    }
+
+private:
+    std::ofstream& m_Stream;
+    std::string m_Buffer;
+    std::size_t m_LineLength;
+};
+
+bool SaveRle(const std::string& path, const Hashlife& life)
+{
+    std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+    if (!stream.is_open())
+    {
+        std::cerr << "Failed to create pattern file: " << path << std::endl;
+        return false;
+    }
+
+    PatternReader reader(life);
+    int64_t left = 0, top = 0, right = 0, bottom = 0;
+    if (!reader.GetBounds(left, top, right, bottom))
+        right = bottom = left = top = 0;
+
+    RleEncoder encoder(stream);
+    encoder.Text("#CXRLE Pos=" + std::to_string(left) + "," + std::to_string(top)
+                 + " Gen=" + std::to_string(life.GetGeneration()) + "\n");
+    encoder.Text("x = " + std::to_string(right - left) + ", y = " + std::to_string(bottom - top)
+                 + ", rule = B3/S23\n");
+
+    // Blank rows collapse into the count on the next row's '$'
+    int64_t lastRow = top;
+    bool ok = reader.ForEachBand([&](int64_t band, const std::vector<PatternLeaf>& leaves)
+    {
+        for (int64_t r = 0; r < 8; r++)
+        {
+            int64_t y = band * 8 + r;
+            int64_t x = left;          // first cell not written yet
+            int64_t runStart = 0;
+            uint64_t runLength = 0;
+            for (const PatternLeaf& leaf : leaves)
+            {
+                unsigned int cells = (unsigned int)(leaf.bits >> (r * 8)) & 0xFF;
+                while (cells)
+                {
+                    unsigned int bit = (unsigned int)__builtin_ctz(cells);
+                    unsigned int length = (unsigned int)__builtin_ctz(~(cells >> bit));
+                    int64_t start = leaf.column * 8 + bit;
+                    cells &= ~(((1u << length) - 1) << bit);
+
+                    // Runs carry on across leaf edges
+                    if (runLength && runStart + (int64_t)runLength == start)
+                    {
+                        runLength += length;
+                        continue;
+                    }
+                    if (runLength)
+                    {
+                        encoder.Run(runLength, 'o');
+                        x = runStart + (int64_t)runLength;
+                    }
+                    else if (y > lastRow)
+                        encoder.Run((uint64_t)(y - lastRow), '$');
+                    if (start > x)
+                        encoder.Run((uint64_t)(start - x), 'b');
+                    runStart = start;
+                    runLength = length;
+                    lastRow = y;
+                }
+            }
+            if (runLength)
+                encoder.Run(runLength, 'o');
+        }
+        return (bool)stream;
+    });
+    encoder.Text("!\n");
+    if (!ok || !encoder.Flush())
+    {
+        std::cerr << "Failed to write pattern file: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+
+class Hashlife;
+
+/**
+ * Run length encoded patterns (.rle), the format most Life patterns ship in.
+ *
+ * Loading maps the file and cuts the runs after '$' into chunks. A first pass
+ * adds up each chunk's '$' counts to find the row it starts on, then all
+ * chunks decode into leaf bitmaps in parallel and the tree is built bottom up
+ * band by band (see ChunkedLoader.h). Saving streams in fixed size chunks,
+ * walking the tree band by band the same way.
+ *
+ * A loaded pattern replaces the universe. SaveRle writes Golly's
+ * "#CXRLE Pos=x,y Gen=n" line, so a pattern that has one goes back to the
+ * same place and generation, anything else is centred on the origin.
+ */
+bool LoadRle(const std::string& path, Hashlife& life);
+bool SaveRle(const std::string& path, const Hashlife& life);
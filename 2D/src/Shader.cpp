@@ -0,0 +1,310 @@
+#include "Shader.h"
+#include "Renderer.h"
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// Program binary file: this header, then `length` bytes for glProgramBinary
+struct ProgramBinaryHeader
+{
+    char magic[8];
+    uint32_t format;
+    uint32_t length;
+};
+
+static const char ProgramBinaryMagic[8] = { 'G', 'O', 'L', 'P', 'R', 'O', 'G', '1' };
+static const uint32_t MaxProgramBinary = 64u << 20;
+static const std::size_t InitialUniforms = 16;
+
+static uint64_t Hash(uint64_t h, const char* data, std::size_t length)
+{
+    // FNV-1a, chained so several strings make one key
+    for (std::size_t i = 0; i < length; i++)
+        h = (h ^ (unsigned char)data[i]) * 0x100000001B3ull;
+    return h;
+}
+
+static uint64_t Hash(const std::string& text, uint64_t h = 0xCBF29CE484222325ull)
+{
+    // The terminator goes in too, so ("ab", "c") and ("a", "bc") differ
+    return Hash(h, text.c_str(), text.size() + 1);
+}
+
+// Makes `path` and any parents that are missing
+static bool MakeDirectories(const std::string& path)
+{
+    for (std::size_t slash = path.find('/', 1); ; slash = path.find('/', slash + 1))
+    {
+        std::string directory = path.substr(0, slash);
+        if (mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST)
+            return false;
+        if (slash == std::string::npos)
+            return true;
+    }
+}
+
+static std::string GetString(GLenum name)
+{
+    const GLubyte* text = glGetString(name);
+    return text ? (const char*)text : "";
+}
+
+static bool BinariesSupported()
+{
+    if (!GLAD_GL_VERSION_4_1 || !glGetProgramBinary || !glProgramBinary)
+        return false;
+    int formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    return formats > 0;
+}
+
+Shader::Shader(const std::string& vertexSource, const std::string& fragmentSource, const std::string& cacheDirectory)
+    : m_RendererID(0), m_Cached(false), m_Uniforms(InitialUniforms), m_UniformCount(0)
+{
+    std::string path;
+    if (!cacheDirectory.empty() && BinariesSupported())
+    {
+        uint64_t key = Hash(vertexSource);
+        key = Hash(fragmentSource, key);
+        key = Hash(GetString(GL_VENDOR), key);
+        key = Hash(GetString(GL_RENDERER), key);
+        key = Hash(GetString(GL_VERSION), key);
+        char name[32];
+        std::snprintf(name, sizeof(name), "/%016llx.bin", (unsigned long long)key);
+        path = cacheDirectory + name;
+        if (LoadBinary(path))
+        {
+            m_Cached = true;
+            return;
+        }
+    }
+
+    m_RendererID = CreateShader(vertexSource, fragmentSource);
+    if (m_RendererID && !path.empty())
+    {
+        if (!MakeDirectories(cacheDirectory))
+            std::cerr << "Failed to create shader cache directory " << cacheDirectory << ": "
+                      << std::strerror(errno) << std::endl;
+        else
+            SaveBinary(path);
+    }
+}
+
+Shader::~Shader()
+{
+    if (m_RendererID)
+        glDeleteProgram(m_RendererID);
+}
+
+void Shader::Bind() const
+{
+    glUseProgram(m_RendererID);
+}
+
+void Shader::UnBind() const
+{
+    glUseProgram(0);
+}
+
+void Shader::Adopt(unsigned int program)
+{
+    if (m_RendererID)
+        glDeleteProgram(m_RendererID);
+    m_RendererID = program;
+    m_Cached = false;
+    m_Uniforms.assign(InitialUniforms, Uniform());
+    m_UniformCount = 0;
+}
+
+int Shader::GetUniformLocation(const char* name)
+{
+    std::size_t length = std::strlen(name);
+    uint64_t hash = Hash(0xCBF29CE484222325ull, name, length);
+    std::size_t mask = m_Uniforms.size() - 1;
+    std::size_t i = hash & mask;
+    for (; !m_Uniforms[i].name.empty(); i = (i + 1) & mask)
+        if (m_Uniforms[i].hash == hash && m_Uniforms[i].name == name)
+            return m_Uniforms[i].location;
+
+    int location = m_RendererID ? glGetUniformLocation(m_RendererID, name) : -1;
+    // Kept at most half full so probes stay short
+    if ((m_UniformCount + 1) * 2 > m_Uniforms.size())
+    {
+        std::vector<Uniform> old(m_Uniforms.size() * 2);
+        old.swap(m_Uniforms);
+        mask = m_Uniforms.size() - 1;
+        for (Uniform& uniform : old)
+        {
+            if (uniform.name.empty())
+                continue;
+            std::size_t j = uniform.hash & mask;
+            while (!m_Uniforms[j].name.empty())
+                j = (j + 1) & mask;
+            m_Uniforms[j] = std::move(uniform);
+        }
+        for (i = hash & mask; !m_Uniforms[i].name.empty(); i = (i + 1) & mask)
+            ;
+    }
+    m_Uniforms[i] = { std::string(name, length), hash, location };
+    m_UniformCount++;
+    return location;
+}
+
+void Shader::SetUniform1i(const char* name, int value)
+{
+    glUniform1i(GetUniformLocation(name), value);
+}
+
+void Shader::SetUniform2i(const char* name, int x, int y)
+{
+    glUniform2i(GetUniformLocation(name), x, y);
+}
+
+void Shader::SetUniform1f(const char* name, float value)
+{
+    glUniform1f(GetUniformLocation(name), value);
+}
+
+void Shader::SetUniform2f(const char* name, float x, float y)
+{
+    glUniform2f(GetUniformLocation(name), x, y);
+}
+
+unsigned int Shader::CompileShader(unsigned int type, const std::string& source)
+{
+    unsigned int id = glCreateShader(type);
+    const char* src = source.c_str();
+    glShaderSource(id, 1, &src, nullptr);
+    glCompileShader(id);
+
+    int result;
+    glGetShaderiv(id, GL_COMPILE_STATUS, &result);
+    if (result == GL_FALSE)
+    {
+        int length;
+        glGetShaderiv(id, GL_INFO_LOG_LENGTH, &length);
+        std::string message(std::max(length, 1), '\0');
+        glGetShaderInfoLog(id, length, &length, &message[0]);
+        std::cerr << "Failed to compile " << (type == GL_VERTEX_SHADER ? "vertex": "fragment") << " shader" << std::endl;
+        std::cerr << message.c_str() << std::endl;
+        glDeleteShader(id);
+        return 0;
+    }
+
+    return id;
+}
+
+unsigned int Shader::CreateShader(const std::string& vertexSource, const std::string& fragmentSource)
+{
+    unsigned int vs = CompileShader(GL_VERTEX_SHADER, vertexSource);
+    unsigned int fs = CompileShader(GL_FRAGMENT_SHADER, fragmentSource);
+    if (vs == 0 || fs == 0)
+    {
+        std::cerr << "Shader compilation failed!" << std::endl;
+        glDeleteShader(vs);
+        glDeleteShader(fs);
+        return 0;
+    }
+
+    unsigned int program = glCreateProgram();
+    glAttachShader(program, vs);
+    glAttachShader(program, fs);
+    // Asked for before linking, some drivers keep nothing to hand back otherwise
+    if (GLAD_GL_VERSION_4_1 && glProgramParameteri)
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glLinkProgram(program);
+    glDeleteShader(vs);
+    glDeleteShader(fs);
+
+    int success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        int length;
+        glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+        std::string message(std::max(length, 1), '\0');
+        glGetProgramInfoLog(program, length, &length, &message[0]);
+        std::cerr << "Shader program link failed:\n"
+                  << message.c_str() << std::endl;
+
+        glDeleteProgram(program);
+        return 0;
+    }
+
+    return program;
+}
+
+// A missing file is the usual cold start and says nothing, a bad one is compiled over
+bool Shader::LoadBinary(const std::string& path)
+{
+    std::ifstream stream(path, std::ios::binary);
+    if (!stream)
+        return false;
+    ProgramBinaryHeader header;
+    if (!stream.read((char*)&header, sizeof(header)) ||
+        std::memcmp(header.magic, ProgramBinaryMagic, sizeof(ProgramBinaryMagic)) != 0 ||
+        header.length == 0 || header.length > MaxProgramBinary)
+    {
+        std::cerr << "Ignoring bad shader cache file: " << path << std::endl;
+        return false;
+    }
+    std::vector<char> binary(header.length);
+    if (!stream.read(binary.data(), (std::streamsize)binary.size()))
+    {
+        std::cerr << "Ignoring truncated shader cache file: " << path << std::endl;
+        return false;
+    }
+
+    unsigned int program = glCreateProgram();
+    glProgramBinary(program, header.format, binary.data(), (GLsizei)binary.size());
+    int success = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        glDeleteProgram(program);
+        return false;
+    }
+    m_RendererID = program;
+    return true;
+}
+
+// Written next to the target and renamed over it, so another run never reads half a file
+void Shader::SaveBinary(const std::string& path) const
+{
+    int length = 0;
+    glGetProgramiv(m_RendererID, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0 || (uint32_t)length > MaxProgramBinary)
+        return;
+    std::vector<char> binary((std::size_t)length);
+    ProgramBinaryHeader header;
+    std::memcpy(header.magic, ProgramBinaryMagic, sizeof(ProgramBinaryMagic));
+    GLenum format = 0;
+    glGetProgramBinary(m_RendererID, length, &length, &format, binary.data());
+    header.format = format;
+    header.length = (uint32_t)length;
+
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+        stream.write((const char*)&header, sizeof(header));
+        stream.write(binary.data(), length);
+        if (!stream.flush())
+        {
+            std::cerr << "Failed to write shader cache file: " << tempPath << std::endl;
+            stream.close();
+            std::remove(tempPath.c_str());
+            return;
+        }
+    }
+    if (std::rename(tempPath.c_str(), path.c_str()) != 0)
+    {
+        std::cerr << "Failed to write shader cache file: " << path << std::endl;
+        std::remove(tempPath.c_str());
+    }
+}
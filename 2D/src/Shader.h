@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * A linked vertex and fragment program and its uniform locations.
+ *
+ * A uniform's location is asked of the driver the first time its name is set
+ * and kept in a small open addressed table, so setting uniforms every frame
+ * costs a hash and a string compare rather than a driver call.
+ *
+ * Given a cache directory, the linked program is saved there with
+ * glGetProgramBinary, named by a hash of both sources and the driver's vendor,
+ * renderer and version strings. The next run with the same sources on the
+ * same driver loads it with glProgramBinary and compiles nothing. A binary the
+ * driver turns down, e.g. after an update that kept its version string, is
+ * compiled over. Binaries need GL 4.1, below that every run compiles.
+ */
+class Shader
+{
+public:
+    Shader(const std::string& vertexSource, const std::string& fragmentSource,
+           const std::string& cacheDirectory = "");
+    ~Shader();
+
+    Shader(const Shader&) = delete;
+    Shader& operator=(const Shader&) = delete;
+
+    // False if compiling or linking failed, the reason went to std::cerr
+    bool IsValid() const { return m_RendererID != 0; }
+    unsigned int GetID() const { return m_RendererID; }
+    // Loaded from the cache directory rather than compiled
+    bool IsCached() const { return m_Cached; }
+
+    void Bind() const;
+    void UnBind() const;
+
+    // Takes over a linked program in place of this one, e.g. a hot reloaded
+    // build. The old program is deleted and locations are asked for again.
+    void Adopt(unsigned int program);
+
+    // -1 for a name the program doesn't use, setting it is then a no-op like in GL
+    int GetUniformLocation(const char* name);
+    void SetUniform1i(const char* name, int value);
+    void SetUniform2i(const char* name, int x, int y);
+    void SetUniform1f(const char* name, float value);
+    void SetUniform2f(const char* name, float x, float y);
+
+    // Returns the shader object, 0 on failure
+    static unsigned int CompileShader(unsigned int type, const std::string& source);
+    // Returns the linked program, 0 on failure
+    static unsigned int CreateShader(const std::string& vertexSource, const std::string& fragmentSource);
+
+private:
+    struct Uniform
+    {
+        std::string name;       // empty for a free entry
+        uint64_t hash;
+        int location;
+    };
+
+    unsigned int m_RendererID;
+    bool m_Cached;
+    std::vector<Uniform> m_Uniforms;    // power of two size, linear probing
+    std::size_t m_UniformCount;
+
+    bool LoadBinary(const std::string& path);
+    void SaveBinary(const std::string& path) const;
+};
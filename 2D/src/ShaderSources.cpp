@@ -0,0 +1,35 @@
+#include "ShaderSources.h"
+
+// Generated from res/shaders by cmake/EmbedShaders.cmake
+#include "EmbeddedShaders.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+std::string LoadShaderSource(const std::string& name, const std::string& directory)
+{
+    std::string source;
+    if (!directory.empty())
+    {
+        if (ReadShaderFile(directory, name, source))
+            return source;
+        std::cerr << "Failed to read shader " << directory << "/" << name << ", using the built in one" << std::endl;
+    }
+
+    for (const EmbeddedShader& shader : EmbeddedShaders)
+        if (shader.name == name)
+            return std::string(shader.source);
+    std::cerr << "No such shader: " << name << std::endl;
+    return "";
+}
+
+bool ReadShaderFile(const std::string& directory, const std::string& name, std::string& source)
+{
+    std::ifstream stream(directory + "/" + name, std::ios::binary);
+    std::stringstream text;
+    if (!stream || !(text << stream.rdbuf()))
+        return false;
+    source = text.str();
+    return true;
+}
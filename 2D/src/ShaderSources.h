@@ -0,0 +1,15 @@
+#pragma once
+
+#include <string>
+
+// Source of a shader by its file name in res/shaders, e.g. "vertex.glsl".
+// The shaders are compiled into the app at build time, so loading one opens
+// no files and works from any directory. For working on them, a non-empty
+// `directory` (--shader-dir) is read instead, and a file that can't be read
+// from there falls back to the built in copy. Empty, with the reason on
+// std::cerr, for a name that isn't a shader.
+std::string LoadShaderSource(const std::string& name, const std::string& directory = "");
+
+// Just the file, no fallback. False if it can't be read, which is no error
+// while an editor is halfway through saving it.
+bool ReadShaderFile(const std::string& directory, const std::string& name, std::string& source);
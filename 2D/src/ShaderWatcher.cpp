@@ -0,0 +1,139 @@
+#include "ShaderWatcher.h"
+#include "Renderer.h"
+#include "Shader.h"
+#include "ShaderSources.h"
+
+#include <GLFW/glfw3.h>
+
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+// How often the thread checks for Stop, and how long changes settle before a rebuild
+static const int PollMs = 100;
+static const int SettleMs = 50;
+
+ShaderWatcher::ShaderWatcher(GLFWwindow* window, const std::string& directory)
+    : m_Window(window), m_Context(nullptr), m_Directory(directory), m_Inotify(-1), m_Stop(false)
+{
+}
+
+ShaderWatcher::~ShaderWatcher()
+{
+    m_Stop = true;
+    if (m_Thread.joinable())
+        m_Thread.join();
+    if (m_Inotify >= 0)
+        close(m_Inotify);
+    // Programs are shared between the contexts, the window's can delete what never got applied
+    for (const Rebuilt& rebuilt : m_Rebuilt)
+        glDeleteProgram(rebuilt.program);
+    if (m_Context)
+        glfwDestroyWindow(m_Context);
+}
+
+void ShaderWatcher::Watch(Shader& shader, const std::string& vertexFile, const std::string& fragmentFile)
+{
+    m_Programs.push_back({ &shader, vertexFile, fragmentFile });
+}
+
+bool ShaderWatcher::Start()
+{
+    m_Inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_Inotify < 0 || inotify_add_watch(m_Inotify, m_Directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+    {
+        std::cerr << "Failed to watch shader directory " << m_Directory << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    // Windows can only be made on the main thread, the other hints are still the ones the window was made with
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    m_Context = glfwCreateWindow(1, 1, "Shader reload", NULL, m_Window);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+    if (!m_Context)
+    {
+        std::cerr << "Failed to create a context for reloading shaders" << std::endl;
+        return false;
+    }
+
+    m_Thread = std::thread(&ShaderWatcher::Run, this);
+    std::cout << "Watching " << m_Directory << " for shader changes" << std::endl;
+    return true;
+}
+
+unsigned int ShaderWatcher::Apply()
+{
+    std::vector<Rebuilt> rebuilt;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        rebuilt.swap(m_Rebuilt);
+    }
+    for (const Rebuilt& program : rebuilt)
+        program.shader->Adopt(program.program);
+    return (unsigned int)rebuilt.size();
+}
+
+void ShaderWatcher::Run()
+{
+    glfwMakeContextCurrent(m_Context);
+    std::set<std::string> changed;
+    alignas(inotify_event) char buffer[4096];
+    while (!m_Stop)
+    {
+        pollfd watched = { m_Inotify, POLLIN, 0 };
+        int ready = poll(&watched, 1, changed.empty() ? PollMs : SettleMs);
+        if (ready > 0)
+        {
+            ssize_t length;
+            while ((length = read(m_Inotify, buffer, sizeof(buffer))) > 0)
+            {
+                for (char* next = buffer; next < buffer + length;)
+                {
+                    const inotify_event* event = (const inotify_event*)next;
+                    if (event->len)
+                        changed.insert(event->name);
+                    next += sizeof(inotify_event) + event->len;
+                }
+            }
+        }
+        else if (ready == 0 && !changed.empty())
+        {
+            Rebuild(changed);
+            changed.clear();
+        }
+    }
+    glfwMakeContextCurrent(nullptr);
+}
+
+void ShaderWatcher::Rebuild(const std::set<std::string>& changed)
+{
+    std::vector<Rebuilt> rebuilt;
+    for (const Program& program : m_Programs)
+    {
+        if (!changed.count(program.vertexFile) && !changed.count(program.fragmentFile))
+            continue;
+        std::string vertexSource, fragmentSource;
+        if (!ReadShaderFile(m_Directory, program.vertexFile, vertexSource) ||
+            !ReadShaderFile(m_Directory, program.fragmentFile, fragmentSource))
+            continue;
+        unsigned int id = Shader::CreateShader(vertexSource, fragmentSource);
+        if (!id)
+        {
+            std::cerr << "Keeping the running " << program.vertexFile << " + " << program.fragmentFile << std::endl;
+            continue;
+        }
+        std::cout << "Reloaded " << program.vertexFile << " + " << program.fragmentFile << std::endl;
+        rebuilt.push_back({ program.shader, id });
+    }
+    if (rebuilt.empty())
+        return;
+
+    // The other context may only use the programs once they're done here
+    glFinish();
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Rebuilt.insert(m_Rebuilt.end(), rebuilt.begin(), rebuilt.end());
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+class Shader;
+struct GLFWwindow;
+
+/**
+ * Hot reload for shaders read from a --shader-dir.
+ *
+ * A thread watches the directory with inotify. When a file a program is made
+ * of is written, or renamed into place as most editors save, the program is
+ * rebuilt on that thread in a hidden context that shares objects with the
+ * window's, so neither the frame loop nor the simulation waits for the
+ * compiler. Rebuilt programs are handed over by Apply, which the frame loop
+ * calls between frames, so a frame is drawn with one set of programs all the
+ * way through. A program that fails to compile or link leaves the running
+ * one in place and its errors on std::cerr.
+ *
+ * A save is often a burst of events, so changes settle for a moment before
+ * anything is rebuilt.
+ */
+class ShaderWatcher
+{
+public:
+    // On the window's thread, like everything here but the watcher itself
+    ShaderWatcher(GLFWwindow* window, const std::string& directory);
+    ~ShaderWatcher();
+
+    ShaderWatcher(const ShaderWatcher&) = delete;
+    ShaderWatcher& operator=(const ShaderWatcher&) = delete;
+
+    // Before Start. Rebuilds `shader` from these files of the directory when
+    // either changes, the shader has to outlive the watcher.
+    void Watch(Shader& shader, const std::string& vertexFile, const std::string& fragmentFile);
+    bool Start();
+
+    // Between frames, swaps in the programs rebuilt since the last call and
+    // returns how many
+    unsigned int Apply();
+
+private:
+    struct Program
+    {
+        Shader* shader;
+        std::string vertexFile;
+        std::string fragmentFile;
+    };
+
+    struct Rebuilt
+    {
+        Shader* shader;
+        unsigned int program;
+    };
+
+    GLFWwindow* m_Window;
+    GLFWwindow* m_Context;        // hidden, current on the watcher thread
+    std::string m_Directory;
+    std::vector<Program> m_Programs;
+    int m_Inotify;
+    std::thread m_Thread;
+    std::atomic<bool> m_Stop;
+
+    std::mutex m_Mutex;
+    std::vector<Rebuilt> m_Rebuilt;
+
+    void Run();
+    void Rebuild(const std::set<std::string>& changed);
+};
@@ -0,0 +1,204 @@
+#include "SnapshotFile.h"
+#include "Hashlife.h"
+#include "MappedFile.h"
+#include "PatternReader.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+static const char SnapshotMagic[8] = { 'H', 'L', 'S', 'N', 'A', 'P', 0, 0 };
+static const uint32_t SnapshotVersion = 1;
+static const uint64_t TileSize = 1 << 20;
+static const std::size_t PageSize = 4096;
+static const char Rule[] = "B3/S23";
+
+struct SnapshotHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t empty;            // 1 when nothing is alive, the bounds are 0 then
+    uint64_t generation;
+    char rule[32];
+    int64_t left, top, right, bottom;   // live cells, right and bottom exclusive
+    uint64_t imageOffset;
+    uint64_t imageSize;
+    uint64_t tileSize;
+    uint64_t tileCount;
+    uint64_t headerChecksum;   // this header with the field zeroed, then the tile sums
+};
+static_assert(sizeof(SnapshotHeader) % 8 == 0, "checksums run over whole words");
+
+// Four independent multiply-xor lanes, fast enough to keep up with the disk
+static uint64_t Checksum(const void* data, std::size_t size, uint64_t seed = 0)
+{
+    const unsigned char* p = (const unsigned char*)data;
+    uint64_t lanes[4] = { seed ^ 0x9E3779B97F4A7C15ull, seed ^ 0xC2B2AE3D27D4EB4Full,
+                          seed ^ 0x165667B19E3779F9ull, seed ^ 0x27D4EB2F165667C5ull };
+    std::size_t i = 0;
+    for (; i + 32 <= size; i += 32)
+    {
+        for (int lane = 0; lane < 4; lane++)
+        {
+            uint64_t word;
+            std::memcpy(&word, p + i + lane * 8, 8);
+            lanes[lane] = (lanes[lane] ^ word) * 0x9E3779B97F4A7C15ull;
+            lanes[lane] ^= lanes[lane] >> 31;
+        }
+    }
+    uint64_t h = size;
+    for (; i < size; i++)
+        h = (h ^ p[i]) * 0x100000001B3ull;
+    for (int lane = 0; lane < 4; lane++)
+        h = (h ^ lanes[lane]) * 0xBF58476D1CE4E5B9ull;
+    return h ^ (h >> 29);
+}
+
+static uint64_t HeaderChecksum(const SnapshotHeader& header, const uint64_t* tileSums)
+{
+    SnapshotHeader copy = header;
+    copy.headerChecksum = 0;
+    return Checksum(tileSums, header.tileCount * sizeof(uint64_t), Checksum(&copy, sizeof(copy)));
+}
+
+// Maps the file and checks everything but the tiles
+static const SnapshotHeader* ReadHeader(const std::string& path, MappedFile& file)
+{
+    if (!file.Open(path, false))
+        return nullptr;
+
+    const SnapshotHeader* header = (const SnapshotHeader*)file.GetData();
+    bool valid = file.GetSize() >= sizeof(SnapshotHeader)
+              && std::memcmp(header->magic, SnapshotMagic, sizeof(SnapshotMagic)) == 0
+              && header->version == SnapshotVersion
+              && header->tileSize == TileSize
+              && header->tileCount == (header->imageSize + TileSize - 1) / TileSize
+              && header->imageOffset % PageSize == 0
+              && header->imageOffset >= sizeof(SnapshotHeader) + header->tileCount * sizeof(uint64_t)
+              && header->imageOffset + header->imageSize == file.GetSize();
+    if (!valid)
+    {
+        std::cerr << "Not a snapshot this build can read: " << path << std::endl;
+        return nullptr;
+    }
+
+    const uint64_t* tileSums = (const uint64_t*)(header + 1);
+    if (HeaderChecksum(*header, tileSums) != header->headerChecksum)
+    {
+        std::cerr << "Snapshot header is corrupt: " << path << std::endl;
+        return nullptr;
+    }
+    if (std::strncmp(header->rule, Rule, sizeof(header->rule)) != 0)
+        std::cerr << "Snapshot: rule " << std::string(header->rule, strnlen(header->rule, sizeof(header->rule)))
+                  << " isn't supported, running it as " << Rule << std::endl;
+    return header;
+}
+
+bool LoadSnapshot(const std::string& path, Hashlife& life)
+{
+    auto start = std::chrono::steady_clock::now();
+    uint64_t imageOffset = 0;
+    {
+        MappedFile file;
+        const SnapshotHeader* header = ReadHeader(path, file);
+        if (!header)
+            return false;
+        imageOffset = header->imageOffset;
+    }
+
+    MappedFile image;
+    if (!image.OpenCopyOnWrite(path, imageOffset) || !life.MapImage(image))
+    {
+        std::cerr << "Failed to load snapshot: " << path << std::endl;
+        return false;
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "Mapped snapshot " << path << " at generation " << life.GetGeneration() << " in "
+              << std::chrono::duration<double, std::milli>(end - start).count() << " ms" << std::endl;
+    return true;
+}
+
+bool SaveSnapshot(const std::string& path, Hashlife& life)
+{
+    std::size_t imageSize = life.PrepareImage();
+    uint64_t tileCount = (imageSize + TileSize - 1) / TileSize;
+    std::size_t imageOffset = sizeof(SnapshotHeader) + tileCount * sizeof(uint64_t);
+    imageOffset = (imageOffset + PageSize - 1) & ~(PageSize - 1);
+
+    // Written next to the target and renamed over it, a crash never leaves half a snapshot
+    std::string tempPath = path + ".tmp";
+    MappedFile file;
+    if (!file.Create(tempPath, imageOffset + imageSize))
+        return false;
+
+    char* base = (char*)file.GetData();
+    life.WriteImage(base + imageOffset);
+
+    uint64_t* tileSums = (uint64_t*)(base + sizeof(SnapshotHeader));
+    ThreadPool pool(life.GetThreadCount());
+    pool.Run((unsigned int)tileCount, [&](unsigned int tile)
+    {
+        uint64_t offset = tile * TileSize;
+        tileSums[tile] = Checksum(base + imageOffset + offset, std::min<uint64_t>(TileSize, imageSize - offset));
+    });
+
+    SnapshotHeader& header = *(SnapshotHeader*)base;
+    std::memcpy(header.magic, SnapshotMagic, sizeof(SnapshotMagic));
+    header.version = SnapshotVersion;
+    header.generation = life.GetGeneration();
+    std::strncpy(header.rule, Rule, sizeof(header.rule));
+    PatternReader reader(life);
+    header.empty = !reader.GetBounds(header.left, header.top, header.right, header.bottom);
+    if (header.empty)
+        header.left = header.top = header.right = header.bottom = 0;
+    header.imageOffset = imageOffset;
+    header.imageSize = imageSize;
+    header.tileSize = TileSize;
+    header.tileCount = tileCount;
+    header.headerChecksum = HeaderChecksum(header, tileSums);
+
+    bool synced = file.Sync();
+    file.Close();
+    if (!synced || std::rename(tempPath.c_str(), path.c_str()) != 0)
+    {
+        std::cerr << "Failed to write snapshot: " << path << std::endl;
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool VerifySnapshot(const std::string& path, unsigned int threadCount)
+{
+    MappedFile file;
+    const SnapshotHeader* header = ReadHeader(path, file);
+    if (!header)
+        return false;
+
+    const char* image = (const char*)file.GetData() + header->imageOffset;
+    const uint64_t* tileSums = (const uint64_t*)(header + 1);
+    std::vector<uint8_t> bad(header->tileCount, 0);
+    ThreadPool pool(std::max(threadCount, 1u));
+    pool.Run((unsigned int)header->tileCount, [&](unsigned int tile)
+    {
+        uint64_t offset = tile * TileSize;
+        uint64_t size = std::min<uint64_t>(TileSize, header->imageSize - offset);
+        bad[tile] = Checksum(image + offset, size) != tileSums[tile];
+    });
+
+    uint64_t badCount = (uint64_t)std::count(bad.begin(), bad.end(), 1);
+    for (uint64_t tile = 0; tile < header->tileCount && badCount; tile++)
+        if (bad[tile])
+            std::cerr << "Snapshot " << path << ": tile " << tile << " at image offset " << tile * TileSize
+                      << " fails its checksum" << std::endl;
+    if (badCount)
+        return false;
+    std::cout << "Snapshot " << path << ": all " << header->tileCount << " tiles check out" << std::endl;
+    return true;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string>
+
+class Hashlife;
+
+/**
+ * Binary snapshots (.snap) of the whole engine, memo included.
+ *
+ * A header page with the generation, rule, bounding box and a checksum per
+ * 1 MiB tile, then an image of the node store exactly as it sits in memory.
+ * Loading maps that image copy-on-write and runs straight out of it, so only
+ * the pages a step actually touches are read and the file is never changed.
+ *
+ * The header is always checked. Tiles are only checked by VerifySnapshot(),
+ * reading every page of a big snapshot up front would defeat the mapping.
+ */
+bool LoadSnapshot(const std::string& path, Hashlife& life);
+bool SaveSnapshot(const std::string& path, Hashlife& life);
+bool VerifySnapshot(const std::string& path, unsigned int threadCount);
@@ -0,0 +1,135 @@
+#include "StreamBuffer.h"
+#include "Renderer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+// Segment offsets stay aligned for any vertex attribute or pixel type
+static const std::size_t SegmentAlignment = 256;
+
+static const GLbitfield PersistentFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+StreamBuffer::StreamBuffer(unsigned int target, unsigned int segmentCount)
+    : m_Target(target), m_RendererID(0), m_SegmentCount(std::max(1u, std::min(segmentCount, MaxSegments))),
+      m_Persistent(GLAD_GL_VERSION_4_4 && glBufferStorage), m_SegmentSize(0), m_Mapped(nullptr), m_Segment(0),
+      m_Fences(), m_WaitMs(0.0)
+{
+    glGenBuffers(1, &m_RendererID);
+}
+
+StreamBuffer::~StreamBuffer()
+{
+    Release();
+    glDeleteBuffers(1, &m_RendererID);
+}
+
+void* StreamBuffer::Map(std::size_t size)
+{
+    if (!m_Persistent)
+    {
+        glBindBuffer(m_Target, m_RendererID);
+        glBufferData(m_Target, (GLsizeiptr)size, nullptr, GL_STREAM_DRAW);
+        m_SegmentSize = size;
+        return glMapBufferRange(m_Target, 0, (GLsizeiptr)size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    }
+
+    if (size > m_SegmentSize && !Allocate(size))
+    {
+        // Storage is immutable, if a bigger one can't be had orphaning still works
+        std::cerr << "Persistent buffer mapping failed, falling back to orphaning" << std::endl;
+        m_Persistent = false;
+        return Map(size);
+    }
+    m_Segment = (m_Segment + 1) % m_SegmentCount;
+    Wait(m_Segment);
+    glBindBuffer(m_Target, m_RendererID);
+    return m_Mapped + m_Segment * m_SegmentSize;
+}
+
+bool StreamBuffer::Unmap()
+{
+    // Coherent writes reach the GPU by themselves
+    if (m_Persistent)
+        return true;
+    glBindBuffer(m_Target, m_RendererID);
+    return glUnmapBuffer(m_Target) == GL_TRUE;
+}
+
+void StreamBuffer::Fence()
+{
+    if (!m_Persistent)
+        return;
+    if (m_Fences[m_Segment])
+        glDeleteSync((GLsync)m_Fences[m_Segment]);
+    m_Fences[m_Segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void StreamBuffer::Bind() const
+{
+    glBindBuffer(m_Target, m_RendererID);
+}
+
+void StreamBuffer::UnBind() const
+{
+    glBindBuffer(m_Target, 0);
+}
+
+// A new buffer with room for `segmentSize` per segment, the old one is waited out first
+bool StreamBuffer::Allocate(std::size_t segmentSize)
+{
+    Release();
+    glDeleteBuffers(1, &m_RendererID);
+    glGenBuffers(1, &m_RendererID);
+
+    m_SegmentSize = (segmentSize + SegmentAlignment - 1) & ~(SegmentAlignment - 1);
+    GLsizeiptr total = (GLsizeiptr)(m_SegmentSize * m_SegmentCount);
+    glBindBuffer(m_Target, m_RendererID);
+    glBufferStorage(m_Target, total, nullptr, PersistentFlags);
+    m_Mapped = (uint8_t*)glMapBufferRange(m_Target, 0, total, PersistentFlags);
+    glBindBuffer(m_Target, 0);
+    if (!m_Mapped)
+    {
+        // An immutable buffer can't be orphaned, the fallback needs a fresh one
+        glDeleteBuffers(1, &m_RendererID);
+        glGenBuffers(1, &m_RendererID);
+        m_SegmentSize = 0;
+        return false;
+    }
+    m_Segment = m_SegmentCount - 1;
+    return true;
+}
+
+void StreamBuffer::Wait(unsigned int segment)
+{
+    GLsync fence = (GLsync)m_Fences[segment];
+    if (!fence)
+        return;
+    auto start = std::chrono::steady_clock::now();
+    // The first wait flushes, so the fence can't be stuck in an unsubmitted batch
+    GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+    for (;;)
+    {
+        GLenum result = glClientWaitSync(fence, flags, 1000000000);
+        if (result != GL_TIMEOUT_EXPIRED)
+            break;
+        flags = 0;
+    }
+    glDeleteSync(fence);
+    m_Fences[segment] = nullptr;
+    m_WaitMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Waits out every segment and drops the mapping
+void StreamBuffer::Release()
+{
+    for (unsigned int i = 0; i < MaxSegments; i++)
+        Wait(i);
+    if (m_Mapped)
+    {
+        glBindBuffer(m_Target, m_RendererID);
+        glUnmapBuffer(m_Target);
+        glBindBuffer(m_Target, 0);
+        m_Mapped = nullptr;
+    }
+}
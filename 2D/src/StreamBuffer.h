@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Buffer object for data that is rewritten every frame, e.g. cell rasters on
+ * their way into a texture or per-instance data.
+ *
+ * With GL 4.4 (ARB_buffer_storage) the buffer is a ring of equal segments,
+ * allocated once with glBufferStorage and mapped persistently and coherently
+ * for its whole life. Map hands out the next segment's memory straight away,
+ * there's no map or unmap per frame. A fence goes in after the commands that
+ * read a segment and is waited on before the segment is handed out again, so
+ * the CPU never overwrites data the GPU hasn't read yet.
+ *
+ * On 3.3 there's a single segment. Every Map orphans the buffer with
+ * glBufferData(NULL) and maps it with invalidation, so the driver swaps in
+ * fresh memory rather than waiting for the GPU.
+ *
+ * Map, Unmap and Fence make GL calls and belong on the context's thread. The
+ * memory between Map and Unmap can be written from any thread, e.g. by the
+ * simulation's workers.
+ */
+class StreamBuffer
+{
+public:
+    static constexpr unsigned int MaxSegments = 4;
+
+    // `target` is the binding point the buffer is used through, e.g. GL_PIXEL_UNPACK_BUFFER
+    StreamBuffer(unsigned int target, unsigned int segmentCount = 3);
+    ~StreamBuffer();
+
+    StreamBuffer(const StreamBuffer&) = delete;
+    StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+    bool IsPersistent() const { return m_Persistent; }
+
+    // Memory for `size` bytes in the next segment, the buffer is left bound.
+    // nullptr if it couldn't be mapped.
+    void* Map(std::size_t size);
+    // Done writing. False if the contents were lost on the way (only without
+    // persistent mapping, e.g. to a mode switch), the segment mustn't be used then.
+    bool Unmap();
+    // Call after the commands reading the segment, it isn't handed out again until they've run
+    void Fence();
+
+    // Byte offset of the segment last mapped, where the commands reading it start
+    std::size_t GetOffset() const { return m_Persistent ? m_Segment * m_SegmentSize : 0; }
+
+    void Bind() const;
+    void UnBind() const;
+
+    // Time Map spent waiting on the GPU to finish with a segment
+    double GetWaitMs() const { return m_WaitMs; }
+
+private:
+    unsigned int m_Target;
+    unsigned int m_RendererID;
+    unsigned int m_SegmentCount;
+    bool m_Persistent;
+    std::size_t m_SegmentSize;
+    uint8_t* m_Mapped;                    // the whole persistent mapping
+    unsigned int m_Segment;               // last handed out
+    void* m_Fences[MaxSegments];          // GLsync, one per segment still being read
+    double m_WaitMs;
+
+    bool Allocate(std::size_t segmentSize);
+    void Wait(unsigned int segment);
+    void Release();
+};
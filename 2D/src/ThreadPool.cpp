@@ -0,0 +1,77 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(unsigned int threadCount)
+    :m_Stopping(false)
+{
+    // The thread calling Run() is a worker too
+    for (unsigned int i = 1; i < threadCount; i++)
+        m_Workers.emplace_back(&ThreadPool::WorkerLoop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stopping = true;
+    }
+    m_Wake.notify_all();
+    for (std::thread& worker : m_Workers)
+        worker.join();
+}
+
+void ThreadPool::Run(unsigned int count, const std::function<void(unsigned int)>& task)
+{
+    if (m_Workers.empty() || count < 2)
+    {
+        for (unsigned int i = 0; i < count; i++)
+            task(i);
+        return;
+    }
+
+    Batch batch = { &task, count };
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    // Newest work goes to the front so nested batches finish first (LIFO)
+    for (unsigned int i = count; i > 1; i--)
+        m_Queue.push_front({ &batch, i - 1 });
+    m_Wake.notify_all();
+
+    // Do the first piece ourselves, then help out until the batch is done
+    Execute(lock, { &batch, 0 });
+    while (batch.remaining > 0)
+    {
+        if (!m_Queue.empty())
+        {
+            Task next = m_Queue.front();
+            m_Queue.pop_front();
+            Execute(lock, next);
+        }
+        else
+            m_Wake.wait(lock);
+    }
+}
+
+void ThreadPool::WorkerLoop()
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    for (;;)
+    {
+        m_Wake.wait(lock, [this] { return m_Stopping || !m_Queue.empty(); });
+        if (m_Stopping)
+            return;
+
+        Task task = m_Queue.front();
+        m_Queue.pop_front();
+        Execute(lock, task);
+    }
+}
+
+// Runs one task with the lock released, lock is held again on return
+void ThreadPool::Execute(std::unique_lock<std::mutex>& lock, Task task)
+{
+    lock.unlock();
+    (*task.batch->task)(task.index);
+    lock.lock();
+
+    if (--task.batch->remaining == 0)
+        m_Wake.notify_all();
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Fixed set of worker threads sharing one task queue.
+ *
+ * Run() blocks until its batch is done but the calling thread keeps taking
+ * tasks off the queue while it waits, so tasks can safely call Run() again
+ * (nested fork/join) without running out of threads.
+ */
+class ThreadPool
+{
+public:
+    ThreadPool(unsigned int threadCount);
+    ~ThreadPool();
+
+    unsigned int GetThreadCount() const { return (unsigned int)m_Workers.size() + 1; }
+
+    // Calls task(0) ... task(count - 1), spread over the pool
+    void Run(unsigned int count, const std::function<void(unsigned int)>& task);
+
+private:
+    struct Batch
+    {
+        const std::function<void(unsigned int)>* task;
+        unsigned int remaining;
+    };
+
+    struct Task
+    {
+        Batch* batch;
+        unsigned int index;
+    };
+
+    std::vector<std::thread> m_Workers;
+    std::deque<Task> m_Queue;
+    std::mutex m_Mutex;
+    std::condition_variable m_Wake;      // new work queued or a batch finished
+    bool m_Stopping;
+
+    void WorkerLoop();
+    void Execute(std::unique_lock<std::mutex>& lock, Task task);
+};
@@ -12,7 +12,7 @@ VertexBuffer::VertexBuffer(const void* data, unsigned int size)
 
 VertexBuffer::~VertexBuffer()
 {
-    glDeleteBuffers(GL_ARRAY_BUFFER, &m_RendererID);
+    glDeleteBuffers(1, &m_RendererID);
 }
 
 void VertexBuffer::Bind() const
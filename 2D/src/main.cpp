@@ -1,93 +1,24 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include <algorithm>
+#include <memory>
 #include <iostream>
-#include <fstream>
 #include <string>
-#include <sstream>
-
-#include "IndexBuffer.h"
-#include "VertexBuffer.h"
-
-static std::string ParseShader(const std::string &filePath)
-{
-    std::ifstream stream(filePath);
-    if (!stream.is_open())
-    {
-        std::cerr << "❌ Failed to open shader file: " << filePath << std::endl;
-        return "";
-    }
-
-    std::stringstream ss;
-    ss << stream.rdbuf();
-    std::string source = ss.str();
-
-    std::cout << "Loaded shader: " << filePath << "\n";
-    std::cout << "Shader length: " << source.length() << std::endl;
-
-    return source;
-}
-
-static unsigned int CompileShader(unsigned int type, const std::string& source)
-{
-    unsigned int id = glCreateShader(type);
-    const char* src = source.c_str();
-    glShaderSource(id, 1, &src, nullptr);
-    glCompileShader(id);
-
-    int result;
-    glGetShaderiv(id, GL_COMPILE_STATUS, &result);
-    if (result == GL_FALSE)
-    {
-        int length;
-        glGetShaderiv(id, GL_INFO_LOG_LENGTH, &length);
-        char message[length];
-        glGetShaderInfoLog(id, length, &length, message);
-        std::cerr << "Failed to compile " << (type == GL_VERTEX_SHADER ? "vertex": "fragment") << " shader" << std::endl;
-        std::cerr << message << std::endl;
-        glDeleteShader(id);
-        return 0;
-    }
-
-    return id;
-}
-
-static unsigned int CreateShader(const std::string &vertexShader,
-                                 const std::string &fragmentShader)
-{
-    unsigned int program = glCreateProgram();
-    unsigned int vs = CompileShader(GL_VERTEX_SHADER, vertexShader);
-    unsigned int fs = CompileShader(GL_FRAGMENT_SHADER, fragmentShader);
-
-    if (vs == 0 || fs == 0)
-    {
-        std::cerr << "Shader compilation failed!" << std::endl;
-        return 0;
-    }
-
-    glAttachShader(program, vs);
-    glAttachShader(program, fs);
-    glLinkProgram(program);
-
-    int success;
-    glGetProgramiv(program, GL_LINK_STATUS, &success);
-    if (!success)
-    {
-        int length;
-        glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
-        char message[length];
-        glGetProgramInfoLog(program, length, &length, message);
-        std::cerr << "Shader program link failed:\n"
-                  << message << std::endl;
-
-        glDeleteProgram(program);
-        return 0;
-    }
-
-    glDeleteShader(vs);
-    glDeleteShader(fs);
-
-    return program;
-}
+#include <thread>
+
+#include "Camera.h"
+#include "CellRenderer.h"
+#include "Checkpointer.h"
+#include "GenerationStream.h"
+#include "Hashlife.h"
+#include "History.h"
+#include "HyperspeedController.h"
+#include "Options.h"
+#include "PatternFile.h"
+#include "Shader.h"
+#include "ShaderSources.h"
+#include "ShaderWatcher.h"
+#include "SnapshotFile.h"
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
     glViewport(0, 0, width, height);
@@ -147,13 +78,73 @@ void debug_callback(
     std::cout << "---------------------opengl-callback-end--------------" << std::endl;
 }
 
+// True once per press rather than every frame the key is held
+static bool KeyPressed(GLFWwindow* window, int key)
+{
+    static bool s_Down[GLFW_KEY_LAST + 1] = {};
+    bool down = glfwGetKey(window, key) == GLFW_PRESS;
+    bool pressed = down && !s_Down[key];
+    s_Down[key] = down;
+    return pressed;
+}
+
 void processInput(GLFWwindow* window) 
 {
     if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window, true);
 }
 
-int main() {
+int main(int argc, char** argv) {
+
+    Options options;
+    if (!ParseOptions(argc, argv, options))
+        return -1;
+    // Frames streamed to stdout can't share it with the log
+    if (options.streamFile == "-")
+        std::cout.rdbuf(std::cerr.rdbuf());
+
+    // Simulation, seeded with an R-pentomino when there's nothing to load. It's
+    // all set up before the window, so a bad pattern or stream fails before
+    // there's any GL state to tear down
+    Hashlife life(options.hashlifeMemory);
+    unsigned int threads = options.threads ? options.threads : std::thread::hardware_concurrency();
+    life.SetThreadCount(std::max(threads, 1u));
+    // A node store from an earlier run brings its pattern and results with it
+    if (!options.hashlifeStore.empty() && !life.OpenStore(options.hashlifeStore))
+        std::cerr << "Running without a node store" << std::endl;
+    if (options.verifySnapshot && !VerifySnapshot(options.patternFile, life.GetThreadCount()))
+        return -1;
+    if (!options.patternFile.empty() && !LoadPattern(options.patternFile, life, options.imageThreshold))
+        return -1;
+    if (life.IsEmpty())
+    {
+        life.SetCell(0, -1, true);
+        life.SetCell(1, -1, true);
+        life.SetCell(-1, 0, true);
+        life.SetCell(0, 0, true);
+        life.SetCell(0, 1, true);
+    }
+    // Runs as many generations per frame as fit the budget
+    HyperspeedController hyperspeed(options.frameBudgetMs);
+    hyperspeed.SetMaxStepLog2(options.maxStepLog2);
+    // Checkpoints are written by their own thread while stepping carries on
+    std::unique_ptr<Checkpointer> checkpointer;
+    if (!options.checkpointFile.empty())
+    {
+        checkpointer.reset(new Checkpointer(life, options.checkpointFile));
+        checkpointer->SetInterval(options.checkpointGenerations, options.checkpointSeconds);
+    }
+    // Left and right arrows scrub through the recorded generations, which
+    // pauses the run, space carries on from the one shown
+    std::unique_ptr<History> history;
+    if (options.historyKeyframes)
+    {
+        history.reset(new History(options.historyKeyframes, options.historyMemory));
+        history->Record(life);
+    }
+    GenerationStream stream;
+    if (!options.streamFile.empty() && !stream.Open(options.streamFile, options.streamFullInterval))
+        return -1;
 
     /**
      * This is the basic setup 
@@ -205,82 +196,142 @@ int main() {
     }
 
 
-    // Square vertex positions
-    float vertices[] = {
-        -0.5f, -0.5f,     // bottom left
-         0.5f, -0.5f,     // bottom right
-        -0.5f,  0.5f,     // top left
-         0.5f,  0.5f,     // top right
-    };
-
-    // Has to be unsigned
-    unsigned int indices[] = {
-        0, 1, 3,  // first tri
-        2, 3, 0   // second tri
-    };
-
-
-    // Vertex array object 
-    unsigned int vao;
-    glGenVertexArrays(1, &vao);
-    glBindVertexArray(vao);
-
-    VertexBuffer vb(vertices, 4 * 2 * sizeof(float));
-
-    // Enable the vertex attribute
-    glEnableVertexAttribArray(0);
-    // Set vertex attirbute for position
-    glVertexAttribPointer(
-        0,                  // Index: The index in the vertex array where this attribute is located. For position in this case the index is 0.
-        2,                  // Size: number of components. 2 floats for vertex position.
-        GL_FLOAT,           // TYPE
-        GL_FALSE,           // Normalised: If true normalizes the values to floats between -1.0 and 1.0, positions are already normalized so this is set to false.
-        2 * sizeof(float),  // Stride: The amount of bytes to skip to reach the next vertex 2 floats in this case
-        (void*) 0           // Pointer: The inital offset where the stride starts from
-    );
-
-    // index buffer object
-    IndexBuffer ib(indices, 6);
-    ib.Bind();
-
-
-    std::string vertexShader = ParseShader("../res/shaders/vertex.glsl");
-    std::string fragmentShader = ParseShader("../res/shaders/fragment.glsl");
-    unsigned int shader = CreateShader(vertexShader, fragmentShader);
-    glUseProgram(shader);
-
-    // get uniform ID
-    int location = glGetUniformLocation(shader, "u_Color");
-    
-    float r = 0.0f;
-    float increment = 0.05f;
-    
+    // Shaders are built in unless --shader-dir points at ones to edit. Linked
+    // programs are kept in the shader cache, so a warm start compiles nothing.
+    std::string vertexShader = LoadShaderSource("vertex.glsl", options.shaderDirectory);
+    std::string fragmentShader = LoadShaderSource("fragment.glsl", options.shaderDirectory);
+    std::unique_ptr<Shader> shader(new Shader(vertexShader, fragmentShader, options.shaderCache));
+    std::string instancedVertexShader = LoadShaderSource("instanced_vertex.glsl", options.shaderDirectory);
+    std::string instancedFragmentShader = LoadShaderSource("instanced_fragment.glsl", options.shaderDirectory);
+    std::unique_ptr<Shader> instancedShader(new Shader(instancedVertexShader, instancedFragmentShader,
+                                                       options.shaderCache));
+    std::string densityFragmentShader = LoadShaderSource("density_fragment.glsl", options.shaderDirectory);
+    std::unique_ptr<Shader> densityShader(new Shader(vertexShader, densityFragmentShader, options.shaderCache));
+    if (shader->IsCached() && instancedShader->IsCached() && densityShader->IsCached())
+        std::cout << "Shaders loaded from " << options.shaderCache << std::endl;
+
+    // Cells come from a bit-packed texture, one full-window triangle per frame,
+    // as one quad per live cell when the view is sparse, or from block densities
+    // when zoomed out past a cell per pixel
+    std::unique_ptr<CellRenderer> renderer(new CellRenderer(*shader, *instancedShader, *densityShader,
+                                                            options.uploadBuffers));
+    // Shaders from --shader-dir are rebuilt in the background when saved and
+    // swapped in between frames, the run carries on throughout
+    std::unique_ptr<ShaderWatcher> watcher;
+    if (!options.shaderDirectory.empty())
+    {
+        watcher.reset(new ShaderWatcher(window, options.shaderDirectory));
+        watcher->Watch(*shader, "vertex.glsl", "fragment.glsl");
+        watcher->Watch(*instancedShader, "instanced_vertex.glsl", "instanced_fragment.glsl");
+        watcher->Watch(*densityShader, "vertex.glsl", "density_fragment.glsl");
+        if (!watcher->Start())
+            watcher.reset();
+    }
+    // Drag or WASD to pan, scroll or +/- to zoom
+    Camera camera(0.0, 0.0, 2.0);
+    camera.Attach(window);
     
     // Game loop
+    bool paused = false;
+    double lastTime = glfwGetTime();
     while (!glfwWindowShouldClose(window))
     {
         // Process input
         processInput(window);
+        double now = glfwGetTime();
+        camera.Update(window, now - lastTime);
+        lastTime = now;
+
+        if (history)
+        {
+            uint64_t generation = 0;
+            if (KeyPressed(window, GLFW_KEY_LEFT) && history->Earlier(life.GetGeneration(), generation)
+                && history->Seek(generation, life))
+                paused = true;
+            if (KeyPressed(window, GLFW_KEY_RIGHT) && history->Later(life.GetGeneration(), generation)
+                && history->Seek(generation, life))
+                paused = true;
+            if (KeyPressed(window, GLFW_KEY_SPACE))
+                paused = false;
+        }
+
+        if (!paused)
+        {
+            if (!hyperspeed.RunFrame(life))
+                glfwSetWindowShouldClose(window, true);
+            if (history)
+                history->Record(life);
+            if (checkpointer)
+                checkpointer->Poll();
+        }
+        if (stream.IsOpen())
+            stream.Write(life);
         
         // Rendering
-        // glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-        // glClear(GL_COLOR_BUFFER_BIT);
-        
-        // if (r > 1.0f)
-        //     increment = -0.05f;
-        // else if (r < 0.0f)
-        //     increment = 0.05f;
-        // r += increment;
-
-        // glUniform4f(location, r, 0.3f, 0.8f, 1.0f);
-        // // Use glDrawElements when using index buffer
-        // glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
+        if (watcher)
+            watcher->Apply();
+        int width = 0, height = 0;
+        glfwGetFramebufferSize(window, &width, &height);
+        renderer->SetView(camera.GetCentreX(), camera.GetCentreY(), camera.GetCellSize());
+        renderer->Draw(life, width, height);
 
         // Check call events and swap buffers
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
-    glDeleteProgram(shader);
+    const HashlifeStats& stats = life.GetStats();
+    std::cout << "Generation " << life.GetGeneration()
+              << ", population " << life.GetPopulation()
+              << ", nodes " << stats.nodeCount << "/" << stats.nodeCapacity
+              << ", hit rate " << stats.HitRate()
+              << ", gc " << stats.gcCount << " (" << stats.totalGcPauseMs << " ms)"
+              << ", " << stats.retries << " steps retried"
+              << ", step 2^" << hyperspeed.GetStepLog2() << std::endl;
+    const RenderStats& rendered = renderer->GetStats();
+    if (rendered.frames)
+    {
+        // Per frame. With upload buffers the upload call returns at once and the
+        // GPU copy overlaps the next frame's fill, without them the call waits.
+        // Buffer waits are the time filling was held up by a copy still running.
+        double frames = (double)rendered.frames;
+        double timed = (double)std::max<uint64_t>(rendered.timedFrames, 1);
+        std::cout << "Rendered " << rendered.frames << " frames, " << renderer->GetUploadMode() << " uploads, "
+                  << rendered.uploadBytes / frames / 1024.0 << " KB in " << rendered.uploadRects / frames
+                  << " pages (" << rendered.evictions << " evicted), " << rendered.instancedFrames
+                  << " instanced (" << rendered.instances / std::max<uint64_t>(rendered.instancedFrames, 1)
+                  << " cells each), " << rendered.densityFrames << " zoomed out ("
+                  << rendered.pendingBlocks << " blocks before their count), fill " << rendered.fillMs / frames
+                  << " ms, buffer wait " << rendered.waitMs / frames
+                  << " ms, upload call " << rendered.submitMs / frames << " ms, GPU upload "
+                  << rendered.gpuUploadMs / timed << " ms, GPU draw " << rendered.gpuDrawMs / timed
+                  << " ms" << std::endl;
+    }
+    if (stream.IsOpen())
+    {
+        stream.Close();
+        const GenerationStreamStats& streamed = stream.GetStats();
+        std::cout << "Streamed " << streamed.frames << " frames (" << streamed.fullFrames << " full), "
+                  << streamed.bytes / 1024 << " KB in " << streamed.writes << " writes, "
+                  << streamed.writeMs << " ms writing" << std::endl;
+    }
+    if (checkpointer)
+    {
+        checkpointer->Wait();
+        CheckpointStats checkpoints = checkpointer->GetStats();
+        std::cout << "Checkpoints " << checkpoints.count << " (" << checkpoints.failures << " failed)"
+                  << ", last at generation " << checkpoints.lastGeneration
+                  << ", " << checkpoints.bytesPerSecond / (1024.0 * 1024.0) << " MB/s"
+                  << ", stepper waited " << stats.pinWaitMs << " ms" << std::endl;
+    }
+
+    if (!options.savePatternFile.empty())
+        SavePattern(options.savePatternFile, life);
+
+    renderer.reset();
+    watcher.reset();
+    densityShader.reset();
+    instancedShader.reset();
+    shader.reset();
     glfwTerminate();
     return 0;
 }
\ No newline at end of file
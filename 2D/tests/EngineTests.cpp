@@ -0,0 +1,352 @@
+#include "Apgcode.h"
+#include "Hashlife.h"
+#include "PatternFile.h"
+#include "PatternReader.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+// Engine and pattern file checks, no window or GL context needed. Every
+// failed check is printed and counted, the exit code is nonzero if any did.
+
+using Cell = std::pair<int64_t, int64_t>;
+using CellSet = std::set<Cell>;
+
+static int s_Failures = 0;
+
+#define CHECK(condition) Check((condition), #condition, __FILE__, __LINE__)
+
+static bool Check(bool condition, const char* text, const char* file, int line)
+{
+    if (!condition)
+    {
+        std::cerr << file << ":" << line << ": check failed: " << text << std::endl;
+        s_Failures++;
+    }
+    return condition;
+}
+
+static CellSet ReadCells(const Hashlife& life)
+{
+    CellSet cells;
+    PatternReader reader(life);
+    reader.ForEachBand([&](int64_t band, const std::vector<PatternLeaf>& leaves)
+    {
+        for (const PatternLeaf& leaf : leaves)
+        {
+            for (unsigned int bit = 0; bit < 64; bit++)
+            {
+                if (leaf.bits >> bit & 1)
+                    cells.insert({ leaf.column * 8 + bit % 8, band * 8 + bit / 8 });
+            }
+        }
+        return true;
+    });
+    return cells;
+}
+
+static void WriteCells(Hashlife& life, const CellSet& cells)
+{
+    life.Clear();
+    for (const Cell& cell : cells)
+        life.SetCell(cell.first, cell.second, true);
+}
+
+// The same cells moved so the bounding box starts at (0, 0)
+static CellSet Shifted(const CellSet& cells)
+{
+    if (cells.empty())
+        return cells;
+    int64_t left = cells.begin()->first, top = cells.begin()->second;
+    for (const Cell& cell : cells)
+    {
+        left = std::min(left, cell.first);
+        top = std::min(top, cell.second);
+    }
+    CellSet shifted;
+    for (const Cell& cell : cells)
+        shifted.insert({ cell.first - left, cell.second - top });
+    return shifted;
+}
+
+static CellSet RandomSoup(std::mt19937_64& random, int64_t size, int64_t offset)
+{
+    CellSet cells;
+    for (int64_t y = 0; y < size; y++)
+    {
+        for (int64_t x = 0; x < size; x++)
+        {
+            if (random() & 1)
+                cells.insert({ x + offset, y + offset });
+        }
+    }
+    return cells;
+}
+
+// One generation of B3/S23, the slow and obvious way
+static CellSet BruteForceStep(const CellSet& cells)
+{
+    std::map<Cell, int> neighbours;
+    for (const Cell& cell : cells)
+    {
+        for (int64_t dy = -1; dy <= 1; dy++)
+        {
+            for (int64_t dx = -1; dx <= 1; dx++)
+            {
+                if (dx || dy)
+                    neighbours[{ cell.first + dx, cell.second + dy }]++;
+            }
+        }
+    }
+    CellSet next;
+    for (const auto& entry : neighbours)
+    {
+        if (entry.second == 3 || (entry.second == 2 && cells.count(entry.first)))
+            next.insert(entry.first);
+    }
+    return next;
+}
+
+static ObjectBoard MakeBoard(const CellSet& cells)
+{
+    ObjectBoard board = {};
+    for (const Cell& cell : cells)
+        board.rows[cell.second] |= (uint64_t)1 << cell.first;
+    NormaliseBoard(board);
+    return board;
+}
+
+// Orientation bit 0 flips x, bit 1 flips y, bit 2 swaps them
+static CellSet Oriented(const CellSet& cells, unsigned int orientation)
+{
+    CellSet oriented;
+    for (const Cell& cell : cells)
+    {
+        int64_t x = orientation & 1 ? -cell.first : cell.first;
+        int64_t y = orientation & 2 ? -cell.second : cell.second;
+        oriented.insert(orientation & 4 ? Cell(y, x) : Cell(x, y));
+    }
+    return Shifted(oriented);
+}
+
+static CellSet CellsFromRows(const std::vector<std::string>& rows)
+{
+    CellSet cells;
+    for (std::size_t y = 0; y < rows.size(); y++)
+    {
+        for (std::size_t x = 0; x < rows[y].size(); x++)
+        {
+            if (rows[y][x] == 'o')
+                cells.insert({ (int64_t)x, (int64_t)y });
+        }
+    }
+    return cells;
+}
+
+static void TestApgcodes()
+{
+    struct Known
+    {
+        const char* apgcode;
+        std::vector<std::string> rows;
+    };
+    const Known known[] = {
+        { "xs4_33", { "oo", "oo" } },
+        { "xs6_696", { ".oo.", "o..o", ".oo." } },
+        { "xs5_253", { "oo.", "o.o", ".o." } },
+        { "xs7_2596", { ".oo.", "o..o", ".o.o", "..o." } },
+        { "xs8_6996", { ".oo.", "o..o", "o..o", ".oo." } },
+        { "xp2_7", { "ooo" } },
+        { "xq4_153", { ".o.", "..o", "ooo" } },
+    };
+    for (const Known& object : known)
+    {
+        CellSet cells = CellsFromRows(object.rows);
+        std::string prefix = std::string(object.apgcode).substr(0, std::string(object.apgcode).find('_'));
+        for (unsigned int orientation = 0; orientation < 8; orientation++)
+        {
+            std::string apgcode = MakeApgcode(prefix, MakeBoard(Oriented(cells, orientation)));
+            if (!CHECK(apgcode == object.apgcode))
+                std::cerr << "    got " << apgcode << " for " << object.apgcode << std::endl;
+        }
+
+        ObjectBoard decoded;
+        CHECK(DecodeApgcode(object.apgcode, decoded));
+        CHECK(MakeApgcode(prefix, decoded) == object.apgcode);
+    }
+
+    // Any object names the same in all 8 orientations and decodes back to one of them
+    std::mt19937_64 random(26);
+    for (int object = 0; object < 2000; object++)
+    {
+        CellSet cells;
+        int64_t size = 1 + (int64_t)(random() % 20);
+        for (unsigned int n = 1 + random() % 30; n; n--)
+            cells.insert({ (int64_t)(random() % size), (int64_t)(random() % size) });
+        std::string canonical = CanonicalWechsler(MakeBoard(cells));
+        for (unsigned int orientation = 1; orientation < 8; orientation++)
+            CHECK(CanonicalWechsler(MakeBoard(Oriented(cells, orientation))) == canonical);
+
+        ObjectBoard decoded;
+        CHECK(DecodeApgcode(canonical, decoded));
+        CHECK(EncodeWechsler(decoded) == canonical);
+        CellSet decodedCells;
+        for (unsigned int y = 0; y < decoded.height; y++)
+        {
+            for (unsigned int x = 0; x < decoded.width; x++)
+            {
+                if (decoded.rows[y] >> x & 1)
+                    decodedCells.insert({ x, y });
+            }
+        }
+        bool found = false;
+        for (unsigned int orientation = 0; orientation < 8; orientation++)
+            found = found || Oriented(cells, orientation) == decodedCells;
+        CHECK(found);
+    }
+}
+
+static void TestHashlifeAgainstBruteForce()
+{
+    std::mt19937_64 random(27);
+    for (int soup = 0; soup < 6; soup++)
+    {
+        Hashlife life(64u << 20);
+        life.SetThreadCount(soup % 2 ? 2 : 1);
+        CellSet cells = RandomSoup(random, 16, -8 + soup * 3);
+        WriteCells(life, cells);
+
+        // Steps of 1 to 32 generations, then some smaller ones mixed back in
+        const unsigned int steps[] = { 0, 1, 2, 3, 4, 5, 0, 2, 1 };
+        uint64_t generation = 0;
+        for (unsigned int stepLog2 : steps)
+        {
+            CHECK(life.Step(stepLog2));
+            for (unsigned int n = 0; n < 1u << stepLog2; n++)
+                cells = BruteForceStep(cells);
+            generation += (uint64_t)1 << stepLog2;
+            CHECK(life.GetGeneration() == generation);
+            CHECK(life.GetPopulation() == cells.size());
+            if (!CHECK(ReadCells(life) == cells))
+                break;
+        }
+        for (const Cell& cell : cells)
+            CHECK(life.GetCell(cell.first, cell.second));
+    }
+}
+
+static void TestRoundTrips(const std::filesystem::path& directory)
+{
+    std::mt19937_64 random(28);
+    // The formats that can be saved, each one keeps position and generation
+    const char* extensions[] = { "rle", "mc", "snap" };
+    for (const char* extension : extensions)
+    {
+        std::string path = (directory / (std::string("soup.") + extension)).string();
+        Hashlife life(64u << 20);
+        WriteCells(life, RandomSoup(random, 40, -13));
+        CHECK(life.Step(3));
+        CHECK(life.Step(2));
+        CellSet saved = ReadCells(life);
+        uint64_t generation = life.GetGeneration();
+        if (!CHECK(SavePattern(path, life)))
+            continue;
+
+        Hashlife loaded(64u << 20);
+        if (!CHECK(LoadPattern(path, loaded)))
+            continue;
+        if (!CHECK(ReadCells(loaded) == saved))
+            std::cerr << "    ." << extension << " moved or changed the pattern" << std::endl;
+        CHECK(loaded.GetGeneration() == generation);
+
+        // The loaded copy runs on the same as the original
+        CHECK(life.Step(2));
+        CHECK(loaded.Step(2));
+        CHECK(ReadCells(loaded) == ReadCells(life));
+    }
+}
+
+static bool WriteFile(const std::string& path, const std::string& contents)
+{
+    std::ofstream file(path, std::ios::binary);
+    file << contents;
+    return (bool)file;
+}
+
+static void TestImages(const std::filesystem::path& directory)
+{
+    // 11x3, a glider and a blinker, rows padded to whole bytes
+    std::vector<std::string> rows = { ".o.....ooo.", "..o........", "ooo........" };
+    CellSet expected = CellsFromRows(rows);
+
+    std::string pbm = "P4\n# comment\n11 3\n";
+    std::string pgm = "P5 11 3 255\n";
+    for (const std::string& row : rows)
+    {
+        unsigned int bits = 0;
+        for (std::size_t x = 0; x < row.size(); x++)
+        {
+            if (row[x] == 'o')
+                bits |= 0x8000u >> x;
+            pgm += row[x] == 'o' ? (char)40 : (char)200;
+        }
+        pbm += (char)(bits >> 8);
+        pbm += (char)(bits & 0xFF);
+    }
+
+    std::string pbmPath = (directory / "glider.pbm").string();
+    std::string pgmPath = (directory / "glider.pgm").string();
+    CHECK(WriteFile(pbmPath, pbm));
+    CHECK(WriteFile(pgmPath, pgm));
+
+    Hashlife life(64u << 20);
+    CHECK(LoadPattern(pbmPath, life));
+    CHECK(Shifted(ReadCells(life)) == expected);
+    CHECK(LoadPattern(pgmPath, life, 0.5));
+    CHECK(Shifted(ReadCells(life)) == expected);
+    // Everything is darker than 0.9 of white
+    CHECK(LoadPattern(pgmPath, life, 0.9));
+    CHECK(life.GetPopulation() == 33);
+
+    // Too big to address, too short for its header and not an image at all
+    std::string hugePath = (directory / "huge.pbm").string();
+    CHECK(WriteFile(hugePath, "P4 1099511627776 134217728\n"));
+    CHECK(!LoadPattern(hugePath, life));
+    std::string shortPath = (directory / "short.pgm").string();
+    CHECK(WriteFile(shortPath, "P5 11 3 255\nabc"));
+    CHECK(!LoadPattern(shortPath, life));
+    std::string badPath = (directory / "bad.pbm").string();
+    CHECK(WriteFile(badPath, "P1 11 3\n"));
+    CHECK(!LoadPattern(badPath, life));
+}
+
+int main()
+{
+    std::filesystem::path directory = std::filesystem::temp_directory_path()
+                                    / ("OpenGLGameOfLife-tests-" + std::to_string(getpid()));
+    std::filesystem::create_directories(directory);
+
+    TestApgcodes();
+    TestHashlifeAgainstBruteForce();
+    TestRoundTrips(directory);
+    TestImages(directory);
+
+    std::filesystem::remove_all(directory);
+    if (s_Failures)
+    {
+        std::cerr << s_Failures << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All checks passed" << std::endl;
+    return 0;
+}